@@ -0,0 +1,540 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "GameEngine.hpp"
+#include "ControllerRobot.hpp"
+
+// Рушій для малих карт (до 64·Words клітинок). Стіни (як маски клітинок,
+// звідки можна ступити в кожен бік), цілі, коробки і робітники за
+// напрямками — бітборди, тож тихий хід (кожен робітник просто
+// зсувається на клітинку) — кілька зсувів і масок без обходу роботів:
+// координати в масивах наздоганяють бітборди лише на подіях. Хід із подією
+// (контролер, зіткнення, загибель, підбір, здача) іде по роботах у тому ж
+// порядку, що й GameEngine::stepAuto, але перевірки — по бітбордах.
+// Результат прогону, хеш стану і безнадійність — ті самі, що в GameEngine.
+// Повтор стану в автоматичному прогоні можливий лише як хід, що нічого не
+// змінив (команди контролерів одноразові, а робітник без поворотів
+// упирається в стіну), тож множина хешів не потрібна. Не підтримуються
+// роботи поза картою чи в стіні, два роботи в одній клітинці і команди,
+// крім поворотів, — тоді load повертає false; advance повертає 0, коли
+// контролер має спрацювати на іншого контролера.
+template<int Words>
+class BitboardEngine {
+public:
+    static constexpr int MaxCells = 64 * Words;
+    using Board = std::bitset<MaxCells>;
+
+    static bool fits(const Level& lvl) { return (long)lvl.getWidth() * lvl.getHeight() <= MaxCells; }
+
+    // стан рушія eng; рельєф читається з його рівня, тож eng має жити довше
+    bool load(const GameEngine& eng);
+    // перенести стан назад у eng
+    void store(GameEngine& eng);
+
+    // один хід із подією або всі тихі ходи до неї; 0 — стан не підтримується
+    int advance(int maxTicks);
+
+    bool isRunning() const { return running_; }
+    bool isWin() const { return undelivered_ == 0; }
+    bool isLose() const { return running_ && (hopeless_ || workersAlive_ == 0); }
+    bool isNonTerminating() const { return nonTerminating_; }
+    bool isFinished() const { return isWin() || isLose() || nonTerminating_; }
+
+    uint64_t getStateHash();
+
+private:
+    const Level* lvl_ = nullptr;
+    int width_ = 0, cells_ = 0;
+    int step_[4] = {};                // зсув індексу клітинки за Direction
+
+    bool wasRunning_ = false;
+    bool running_ = false;
+    bool earlyLose_ = true;
+    bool manual_ = false;
+    bool hopeless_ = false;
+    bool nonTerminating_ = false;
+    int moves_ = 0;
+
+    // роботи у списках у порядку ходу: спершу robots, потім placed; кожен
+    // у своїй клітинці, тож їх не більше MaxCells і масиви — без алокацій
+    int n_ = 0;
+    std::array<int, MaxCells> slot_;  // індекс у Level::getRobotStates()
+    std::array<int, MaxCells> id_;
+    std::array<int16_t, MaxCells> cell_;   // y*W + x станом на shift_ тихих ходів тому
+    std::array<uint8_t, MaxCells> dir_;
+    std::array<uint8_t, MaxCells> worker_;
+    std::array<uint8_t, MaxCells> alive_;
+    std::array<int8_t, MaxCells> cmd_;     // CommandType команди контролера, -1 — немає
+    std::array<int16_t, MaxCells> carry_;  // індекс коробки у boxes_, -1 — без вантажу
+
+    std::vector<std::pair<int, RobotState>> erased_;   // прибрані зі списків: слот і стан
+
+    std::vector<Box> boxes_;
+    int undelivered_ = 0;
+    int workersAlive_ = 0;
+    int deadListed_ = 0;              // мертві, що ще стоять у списку до кінця ходу
+    int shift_ = 0;                   // тихих ходів, не внесених у cell_
+
+    // рельєф у бітбордах; будується раз на розкладку в кожному потоці
+    struct Terrain {
+        uint64_t layout = 0;
+        size_t walls = 0;
+        int width = 0, height = 0;
+        Board targets, canMove[4];    // canMove — сусід у напрямку не стіна і не край
+    };
+    Terrain terrain_;
+
+    Board occupied_, controllers_, fronts_, loose_;
+    Board workers_[4], carriers_[4];  // живі робітники за напрямком; з вантажем
+    int16_t at_[MaxCells];            // клітинка → робот, -1 — порожньо
+    std::vector<uint8_t> carried_;    // коробка в когось у списку; лише для rebuild
+    GameEngine::HopelessInput hopelessIn_;
+
+    static const Terrain& terrainOf(const Level& lvl);
+    static Board shifted(const Board& b, int d, int width);
+    int front(int i) const;
+    // s з координатами, напрямком, життям і вантажем робота i
+    RobotState stateOf(int i, RobotState s) const;
+
+    void materialize();
+    void rebuild();
+    bool quietStep();
+    bool eventTick();
+    bool hopeless(int shift);
+};
+
+template<int Words>
+typename BitboardEngine<Words>::Board BitboardEngine<Words>::shifted(const Board& b, int d, int width) {
+    switch ((Direction)d) {
+        case Direction::Up:    return b >> width;
+        case Direction::Down:  return b << width;
+        case Direction::Left:  return b >> 1;
+        case Direction::Right: return b << 1;
+    }
+    return b;
+}
+
+template<int Words>
+const typename BitboardEngine<Words>::Terrain& BitboardEngine<Words>::terrainOf(const Level& lvl) {
+    static thread_local Terrain t;
+    if (t.layout == lvl.layoutId() && t.walls == lvl.getWalls().size() &&
+        t.width == lvl.getWidth() && t.height == lvl.getHeight())
+        return t;
+
+    t.layout = lvl.layoutId();
+    t.walls = lvl.getWalls().size();
+    t.width = lvl.getWidth();
+    t.height = lvl.getHeight();
+    t.targets.reset();
+    for (auto& m : t.canMove) m.reset();
+    for (int c = 0; c < t.width * t.height; ++c) {
+        int x = c % t.width, y = c / t.width;
+        if (lvl.isTarget(x, y)) t.targets.set(c);
+        for (int d = 0; d < 4; ++d)
+            if (lvl.rayDistance(x, y, (Direction)d) > 0) t.canMove[d].set(c);
+    }
+    return t;
+}
+
+template<int Words>
+bool BitboardEngine<Words>::load(const GameEngine& eng) {
+    const Level& lvl = eng.getLevel();
+    if (!fits(lvl) || lvl.getBoxes().size() > INT16_MAX) return false;
+
+    lvl_ = &lvl;
+    width_ = lvl.getWidth();
+    cells_ = width_ * lvl.getHeight();
+    step_[(int)Direction::Up] = -width_;
+    step_[(int)Direction::Down] = width_;
+    step_[(int)Direction::Left] = -1;
+    step_[(int)Direction::Right] = 1;
+
+    wasRunning_ = running_ = eng.isRunning();
+    earlyLose_ = eng.earlyLose();
+    manual_ = eng.hadManualCommands();
+    hopeless_ = eng.isHopeless();
+    nonTerminating_ = false;
+    moves_ = lvl.getMoves();
+    boxes_ = lvl.getBoxes();
+    erased_.clear();
+
+    terrain_ = terrainOf(lvl);
+
+    n_ = 0;
+
+    Board taken;
+    carried_.assign(boxes_.size(), 0);
+    const auto& states = lvl.getRobotStates();
+    auto collect = [&](const std::vector<std::unique_ptr<Robot>>& arr) {
+        for (auto& r : arr) {
+            const RobotState* s = r->getState();
+            if (!s) return false;
+            size_t k = (size_t)(s->id - 1);
+            if (k >= states.size() || states[k].get() != s) return false;
+
+            if (!lvl.isInside(s->x, s->y) || lvl.isWall(s->x, s->y)) return false;
+            int c = s->y * width_ + s->x;
+            if (taken.test(c)) return false;
+            taken.set(c);
+
+            int8_t cmd = -1;
+            if (auto* ctrl = dynamic_cast<const ControllerRobot*>(r.get())) {
+                if (ctrl->hasPendingCommand()) {
+                    auto t = ctrl->getPendingCommand()->type;
+                    if (t != CommandType::RotateCW && t != CommandType::RotateCCW) return false;
+                    cmd = (int8_t)t;
+                }
+            }
+
+            int carry = -1;
+            if (s->carrying) {
+                if (!s->boxId) return false;
+                for (size_t b = 0; b < boxes_.size(); ++b)
+                    if (boxes_[b].id == *s->boxId) { carry = (int)b; break; }
+                if (carry < 0 || boxes_[carry].delivered || carried_[carry]) return false;
+                carried_[carry] = 1;
+            } else if (s->boxId) {
+                return false;
+            }
+
+            slot_[n_] = (int)k;
+            id_[n_] = s->id;
+            cell_[n_] = (int16_t)c;
+            dir_[n_] = (uint8_t)s->dir;
+            worker_[n_] = s->type == RobotType::Worker;
+            alive_[n_] = s->alive;
+            cmd_[n_] = cmd;
+            carry_[n_] = (int16_t)carry;
+            ++n_;
+        }
+        return true;
+    };
+    if (!collect(lvl.getRobots()) || !collect(lvl.getPlacedRobots())) return false;
+
+    shift_ = 0;
+    rebuild();
+    return true;
+}
+
+template<int Words>
+int BitboardEngine<Words>::front(int i) const {
+    int x = cell_[i] % width_, y = cell_[i] / width_;
+    switch ((Direction)dir_[i]) {
+        case Direction::Up:    --y; break;
+        case Direction::Down:  ++y; break;
+        case Direction::Left:  --x; break;
+        case Direction::Right: ++x; break;
+    }
+    return lvl_->isInside(x, y) ? y * width_ + x : -1;
+}
+
+template<int Words>
+RobotState BitboardEngine<Words>::stateOf(int i, RobotState s) const {
+    int c = cell_[i] + (worker_[i] && alive_[i] ? shift_ * step_[dir_[i]] : 0);
+    s.x = c % width_;
+    s.y = c / width_;
+    s.dir = (Direction)dir_[i];
+    s.alive = alive_[i];
+    s.carrying = carry_[i] >= 0;
+    s.boxId = carry_[i] >= 0 ? std::optional<int>(boxes_[carry_[i]].id) : std::nullopt;
+    return s;
+}
+
+// тихі ходи зсували лише бітборди; тепер — і координати
+template<int Words>
+void BitboardEngine<Words>::materialize() {
+    if (shift_ == 0) return;
+    for (int i = 0; i < n_; ++i) {
+        if (!worker_[i] || !alive_[i]) continue;
+        cell_[i] = (int16_t)(cell_[i] + shift_ * step_[dir_[i]]);
+        if (carry_[i] >= 0) {
+            boxes_[carry_[i]].x = cell_[i] % width_;
+            boxes_[carry_[i]].y = cell_[i] / width_;
+        }
+    }
+    shift_ = 0;
+    rebuild();
+}
+
+template<int Words>
+void BitboardEngine<Words>::rebuild() {
+    occupied_.reset(); controllers_.reset(); fronts_.reset(); loose_.reset();
+    for (int d = 0; d < 4; ++d) { workers_[d].reset(); carriers_[d].reset(); }
+    std::fill(at_, at_ + cells_, -1);
+    workersAlive_ = deadListed_ = undelivered_ = 0;
+
+    std::fill(carried_.begin(), carried_.end(), 0);
+    for (int i = 0; i < n_; ++i) {
+        int c = cell_[i];
+        occupied_.set(c);
+        at_[c] = (int16_t)i;
+        if (carry_[i] >= 0) carried_[carry_[i]] = 1;
+
+        if (!alive_[i]) {
+            ++deadListed_;
+        } else if (worker_[i]) {
+            ++workersAlive_;
+            workers_[dir_[i]].set(c);
+            if (carry_[i] >= 0) carriers_[dir_[i]].set(c);
+        }
+        if (!worker_[i]) {
+            controllers_.set(c);
+            int f = cmd_[i] >= 0 ? front(i) : -1;
+            if (f >= 0) fronts_.set(f);
+        }
+    }
+
+    for (size_t b = 0; b < boxes_.size(); ++b) {
+        if (boxes_[b].delivered) continue;
+        ++undelivered_;
+        if (!carried_[b]) loose_.set(boxes_[b].y * width_ + boxes_[b].x);
+    }
+}
+
+// Хід, у якому нічого не стається: жоден контролер не має перед собою
+// робота, кожен робітник може ступити вперед у клітинку, яку ніхто не
+// займає і більше ніхто не займе, і не наступає ні на коробку (без
+// вантажу), ні на ціль (з вантажем). Тоді порядок ходу неважливий.
+template<int Words>
+bool BitboardEngine<Words>::quietStep() {
+    if (deadListed_ || (fronts_ & occupied_).any()) return false;
+
+    Board next[4], carried[4], moved;
+    for (int d = 0; d < 4; ++d) {
+        if ((workers_[d] & ~terrain_.canMove[d]).any()) return false;
+        next[d] = shifted(workers_[d], d, width_);
+        if ((next[d] & (occupied_ | moved)).any()) return false;
+        carried[d] = shifted(carriers_[d], d, width_);
+        if ((carried[d] & terrain_.targets).any() || ((next[d] ^ carried[d]) & loose_).any()) return false;
+        moved |= next[d];
+    }
+
+    for (int d = 0; d < 4; ++d) {
+        workers_[d] = next[d];
+        carriers_[d] = carried[d];
+    }
+    occupied_ = controllers_ | moved;
+    ++shift_;
+    ++moves_;
+    return true;
+}
+
+// хід з подіями — по роботах, як GameEngine::stepAuto
+template<int Words>
+bool BitboardEngine<Words>::eventTick() {
+    materialize();
+
+    // контролер, що повертає контролера, крутить робота за id з команди
+    for (int i = 0; i < n_; ++i) {
+        int f = cmd_[i] >= 0 ? front(i) : -1;
+        if (f >= 0 && at_[f] >= 0 && !worker_[at_[f]]) return false;
+    }
+
+    // без живих робітників хід нічого не змінює, якщо не спрацює контролер
+    bool idle = workersAlive_ == 0;
+
+    // ===== КОНТРОЛЕРИ =====
+    for (int i = 0; i < n_; ++i) {
+        int f = cmd_[i] >= 0 ? front(i) : -1;
+        if (f < 0 || at_[f] < 0) continue;
+
+        int j = at_[f];
+        bool cw = cmd_[i] == (int8_t)CommandType::RotateCW;
+        cmd_[i] = -1;
+        idle = false;
+        if (!alive_[j]) continue;
+
+        static const uint8_t toCw[4]  = { (uint8_t)Direction::Right, (uint8_t)Direction::Left,
+                                          (uint8_t)Direction::Up,    (uint8_t)Direction::Down };
+        static const uint8_t toCcw[4] = { (uint8_t)Direction::Left,  (uint8_t)Direction::Right,
+                                          (uint8_t)Direction::Down,  (uint8_t)Direction::Up };
+        dir_[j] = cw ? toCw[dir_[j]] : toCcw[dir_[j]];
+    }
+
+    // ===== РУХ WORKER =====
+    for (int i = 0; i < n_; ++i) {
+        if (!worker_[i] || !alive_[i]) continue;
+
+        int c = cell_[i];
+        int n = c + step_[dir_[i]];
+        if (!terrain_.canMove[dir_[i]].test(c) || occupied_.test(n)) {
+            alive_[i] = 0;
+            continue;
+        }
+
+        occupied_.reset(c);
+        occupied_.set(n);
+        cell_[i] = (int16_t)n;
+
+        if (carry_[i] < 0 && loose_.test(n)) {
+            for (size_t b = 0; b < boxes_.size(); ++b) {
+                if (!boxes_[b].delivered && boxes_[b].y * width_ + boxes_[b].x == n) {
+                    carry_[i] = (int16_t)b;
+                    break;
+                }
+            }
+        }
+
+        if (carry_[i] >= 0) {
+            Box& b = boxes_[carry_[i]];
+            b.x = n % width_;
+            b.y = n / width_;
+            if (terrain_.targets.test(n)) {
+                b.delivered = true;
+                carry_[i] = -1;
+            }
+        }
+    }
+
+    // ВИДАЛЕННЯ МЕРТВИХ: їхній стан більше не зміниться
+    int kept = 0;
+    for (int i = 0; i < n_; ++i) {
+        if (!alive_[i]) {
+            erased_.emplace_back(slot_[i], stateOf(i, *lvl_->getRobotStates()[slot_[i]]));
+            continue;
+        }
+        slot_[kept] = slot_[i];
+        id_[kept] = id_[i];
+        cell_[kept] = cell_[i];
+        dir_[kept] = dir_[i];
+        worker_[kept] = worker_[i];
+        alive_[kept] = alive_[i];
+        cmd_[kept] = cmd_[i];
+        carry_[kept] = carry_[i];
+        ++kept;
+    }
+    n_ = (int)kept;
+
+    // Level::update тут нічого не змінює: у стіну робітник не заходить,
+    // а вантаж на цілі вже зданий
+    ++moves_;
+    rebuild();
+    if (idle) nonTerminating_ = true;
+    return true;
+}
+
+template<int Words>
+bool BitboardEngine<Words>::hopeless(int shift) {
+    if (!earlyLose_) return false;
+    materialize();
+
+    GameEngine::HopelessInput& in = hopelessIn_;
+    in.workers.clear();
+    in.fronts.clear();
+    in.manualCommands = manual_;
+    in.boxes = &boxes_;
+    for (int i = 0; i < n_; ++i) {
+        int x = cell_[i] % width_, y = cell_[i] / width_;
+        if (worker_[i]) {
+            if (alive_[i])
+                in.workers.push_back({ x, y, (Direction)dir_[i], carry_[i] >= 0,
+                                       carry_[i] >= 0 ? boxes_[carry_[i]].id : -1 });
+        } else if (cmd_[i] >= 0) {
+            int dx = 0, dy = 0;
+            switch ((Direction)dir_[i]) {
+                case Direction::Up:    dy = -1; break;
+                case Direction::Down:  dy = 1; break;
+                case Direction::Left:  dx = -1; break;
+                case Direction::Right: dx = 1; break;
+            }
+            in.fronts.emplace_back(x + dx, y + dy);
+        }
+    }
+    return GameEngine::hopelessFor(*lvl_, in, shift);
+}
+
+template<int Words>
+int BitboardEngine<Words>::advance(int maxTicks) {
+    if (maxTicks <= 0) return 0;
+
+    if (running_) {
+        int quiet = 0;
+        while (quiet < maxTicks && quietStep()) ++quiet;
+
+        if (quiet > 0) {
+            // під час тихих ходів надії лише меншає: шукаємо перший безнадійний
+            // і повертаємось до нього (див. GameEngine::advance)
+            if (hopeless(0)) {
+                int lo = 0, hi = quiet;
+                while (hi - lo > 1) {
+                    int mid = (lo + hi) / 2;
+                    if (hopeless(mid - quiet)) hi = mid; else lo = mid;
+                }
+                shift_ = hi - quiet;
+                moves_ -= quiet - hi;
+                materialize();
+                hopeless_ = true;
+                return hi;
+            }
+            return quiet;
+        }
+    }
+
+    if (!eventTick()) return 0;
+    running_ = true;
+    hopeless_ = hopeless(0);
+    return 1;
+}
+
+template<int Words>
+uint64_t BitboardEngine<Words>::getStateHash() {
+    materialize();
+
+    uint64_t h = 0;
+    RobotState s{};
+    Command pending{};
+    for (int i = 0; i < n_; ++i) {
+        s.id = id_[i];
+        s.type = worker_[i] ? RobotType::Worker : RobotType::Controller;
+        pending.type = (CommandType)cmd_[i];
+        h ^= GameEngine::robotKeyOf(stateOf(i, s), cmd_[i] >= 0 ? &pending : nullptr);
+    }
+    for (auto& b : boxes_) h ^= GameEngine::boxKeyOf(b);
+    return h;
+}
+
+template<int Words>
+void BitboardEngine<Words>::store(GameEngine& eng) {
+    materialize();
+
+    // eng ще в стані на момент load: переписуємо лише змінене
+    const LevelSnapshot before = eng.getLevel().snapshot();
+    LevelSnapshot snap = before;
+    snap.moves = moves_;
+    snap.boxes = boxes_;
+    for (auto& [k, st] : erased_) {
+        snap.robots[k].state = st;
+        snap.robots[k].listed = false;
+    }
+    for (int i = 0; i < n_; ++i) {
+        RobotSnapshot& rs = snap.robots[slot_[i]];
+        rs.state = stateOf(i, rs.state);
+        rs.hasCommand = cmd_[i] >= 0;
+    }
+
+    // якщо прогін почався тут, стан на момент load — розстановка
+    const LevelSnapshot* started = !running_ ? nullptr
+                                 : wasRunning_ ? eng.getStartedSnapshot() : &before;
+    eng.restoreState(snap, running_, started);
+}
+
+// f(BitboardEngine<Words>&) з найменшим Words, у який вміщається карта eng;
+// false — бітборди вимкнено, карта завелика або стан не підтримується
+template<class F>
+bool withBitboardEngine(const GameEngine& eng, F&& f) {
+    auto run = [&](auto&& bb) {
+        if (!bb.load(eng)) return false;
+        f(bb);
+        return true;
+    };
+    switch (eng.bitboardWords()) {
+        case 1: return run(BitboardEngine<1>());
+        case 2: return run(BitboardEngine<2>());
+        case 4: return run(BitboardEngine<4>());
+    }
+    return false;
+}
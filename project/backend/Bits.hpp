@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+// індекс молодшого встановленого біта (x != 0)
+inline int ctz64(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (int)i;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// індекс старшого встановленого біта (x != 0)
+inline int msb64(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanReverse64(&i, x);
+    return (int)i;
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+inline int popcount64(uint64_t x) {
+#ifdef _MSC_VER
+    return (int)__popcnt64(x);
+#else
+    return __builtin_popcountll(x);
+#endif
+}
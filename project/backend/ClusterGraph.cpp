@@ -0,0 +1,330 @@
+#include "ClusterGraph.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <queue>
+
+ClusterGraph::ClusterGraph(int clusterSize) : size_(std::max(2, clusterSize)) {}
+
+void ClusterGraph::clear() {
+    clusters_.clear();
+    layout_ = 0;
+    wallsSeen_ = 0;
+    width_ = height_ = 0;
+    cols_ = rows_ = 0;
+}
+
+size_t ClusterGraph::clustersBuilt() const {
+    size_t n = 0;
+    for (auto& c : clusters_) n += c.built ? 1 : 0;
+    return n;
+}
+
+void ClusterGraph::sync(const Level& lvl) {
+    lvl_ = &lvl;
+    auto& walls = lvl.getWalls();
+
+    if (lvl.layoutId() != layout_ || lvl.getWidth() != width_ || lvl.getHeight() != height_ ||
+        walls.size() < wallsSeen_)
+    {
+        layout_ = lvl.layoutId();
+        width_ = lvl.getWidth();
+        height_ = lvl.getHeight();
+        wallsSeen_ = walls.size();
+        cols_ = (width_ + size_ - 1) / size_;
+        rows_ = (height_ + size_ - 1) / size_;
+        clusters_.assign((size_t)cols_ * rows_, Cluster{});
+        return;
+    }
+
+    for (; wallsSeen_ < walls.size(); ++wallsSeen_)
+        wallAdded(walls[wallsSeen_].first, walls[wallsSeen_].second);
+}
+
+// входи на межі залежать від клітинок з обох боків — сусід теж застаріває
+void ClusterGraph::wallAdded(int x, int y) {
+    if (x < 0 || y < 0 || x >= width_ || y >= height_) return;
+    const int cx = x / size_, cy = y / size_;
+
+    auto reset = [&](int kx, int ky) {
+        if (kx < 0 || ky < 0 || kx >= cols_ || ky >= rows_) return;
+        Cluster& c = clusters_[(size_t)ky * cols_ + kx];
+        c.built = false;
+        c.nodes.clear();
+        c.dist.clear();
+    };
+
+    reset(cx, cy);
+    if (x % size_ == 0) reset(cx - 1, cy);
+    if (x % size_ == size_ - 1) reset(cx + 1, cy);
+    if (y % size_ == 0) reset(cx, cy - 1);
+    if (y % size_ == size_ - 1) reset(cx, cy + 1);
+}
+
+int ClusterGraph::clusterOf(int cell) const {
+    return (cell / width_ / size_) * cols_ + (cell % width_) / size_;
+}
+
+ClusterGraph::Cluster& ClusterGraph::ensure(int k) {
+    if (!clusters_[k].built) rebuild(k);
+    return clusters_[k];
+}
+
+int ClusterGraph::nodeIndex(const Cluster& c, int cell) const {
+    for (size_t i = 0; i < c.nodes.size(); ++i)
+        if (c.nodes[i].cell == cell) return (int)i;
+    return -1;
+}
+
+// Прохід — найдовша ділянка межі, вільна з обох боків. Короткий дає один
+// вхід посередині, довгий — два по краях, щоб шлях не гнувся до середини.
+void ClusterGraph::addTransitions(Cluster& c, int ax, int ay, int bx, int by, int len, int stepX, int stepY) {
+    auto open = [&](int i) {
+        return !lvl_->isWall(ax + i * stepX, ay + i * stepY) && !lvl_->isWall(bx + i * stepX, by + i * stepY);
+    };
+    auto add = [&](int i) {
+        int mine = (ay + i * stepY) * width_ + ax + i * stepX;
+        int theirs = (by + i * stepY) * width_ + bx + i * stepX;
+        int n = nodeIndex(c, mine);
+        if (n < 0) {
+            c.nodes.push_back(Node{ mine, { theirs, -1 }, 1, 0, 0, 0, false });
+            return;
+        }
+        c.nodes[n].partners[c.nodes[n].partnerCount++] = theirs;
+    };
+
+    for (int i = 0; i < len;) {
+        if (!open(i)) {
+            ++i;
+            continue;
+        }
+        int j = i;
+        while (j < len && open(j)) ++j;
+
+        if (j - i < 6) {
+            add((i + j - 1) / 2);
+        } else {
+            add(i);
+            add(j - 1);
+        }
+        i = j;
+    }
+}
+
+void ClusterGraph::rebuild(int k) {
+    ++rebuilds_;
+    Cluster& c = clusters_[k];
+    c.nodes.clear();
+
+    const int cx = k % cols_, cy = k / cols_;
+    const int x0 = cx * size_, y0 = cy * size_;
+    const int x1 = std::min(width_, x0 + size_) - 1, y1 = std::min(height_, y0 + size_) - 1;
+    const int w = x1 - x0 + 1, h = y1 - y0 + 1;
+
+    if (cy > 0) addTransitions(c, x0, y0, x0, y0 - 1, w, 1, 0);
+    if (cy + 1 < rows_) addTransitions(c, x0, y1, x0, y1 + 1, w, 1, 0);
+    if (cx > 0) addTransitions(c, x0, y0, x0 - 1, y0, h, 0, 1);
+    if (cx + 1 < cols_) addTransitions(c, x1, y0, x1 + 1, y0, h, 0, 1);
+
+    const size_t n = c.nodes.size();
+    c.dist.assign(n * n, -1);
+    for (size_t i = 0; i < n; ++i) {
+        localBfs(k, c.nodes[i].cell);
+        for (size_t j = 0; j < n; ++j)
+            c.dist[i * n + j] = local_[localIndex(k, c.nodes[j].cell)];
+    }
+    c.built = true;
+}
+
+int ClusterGraph::localIndex(int k, int cell) const {
+    const int x0 = (k % cols_) * size_, y0 = (k / cols_) * size_;
+    return (cell / width_ - y0) * size_ + (cell % width_ - x0);
+}
+
+void ClusterGraph::localBfs(int k, int cell) {
+    const int x0 = (k % cols_) * size_, y0 = (k / cols_) * size_;
+    const int x1 = std::min(width_, x0 + size_), y1 = std::min(height_, y0 + size_);
+
+    local_.assign((size_t)size_ * size_, -1);
+    queue_.clear();
+    queue_.push_back(cell);
+    local_[localIndex(k, cell)] = 0;
+
+    const int dx[4] = { 0, 0, -1, 1 };
+    const int dy[4] = { -1, 1, 0, 0 };
+
+    for (size_t head = 0; head < queue_.size(); ++head) {
+        int cur = queue_[head];
+        int x = cur % width_, y = cur / width_;
+        int d = local_[localIndex(k, cur)];
+        for (int i = 0; i < 4; ++i) {
+            int nx = x + dx[i], ny = y + dy[i];
+            if (nx < x0 || ny < y0 || nx >= x1 || ny >= y1 || lvl_->isWall(nx, ny)) continue;
+            int next = ny * width_ + nx;
+            int li = localIndex(k, next);
+            if (local_[li] >= 0) continue;
+            local_[li] = d + 1;
+            queue_.push_back(next);
+        }
+    }
+}
+
+// A* по входах. Старт під'єднано до входів свого кластера, ціль — до входів
+// свого; якщо обидва в одному кластері, пряма відстань теж кандидат.
+int ClusterGraph::search(int s, int t, std::vector<int>* points) {
+    const int ks = clusterOf(s), kt = clusterOf(t);
+    const int Start = -2, Goal = -1;
+
+    std::vector<int32_t> fromStart, toGoal;
+    int direct = -1;
+
+    // перебудова кластера теж користується local_ — спершу ensure
+    ensure(ks);
+    ensure(kt);
+
+    localBfs(ks, s);
+    for (auto& n : clusters_[ks].nodes) fromStart.push_back(local_[localIndex(ks, n.cell)]);
+    if (ks == kt) direct = local_[localIndex(ks, t)];
+
+    localBfs(kt, t);
+    for (auto& n : clusters_[kt].nodes) toGoal.push_back(local_[localIndex(kt, n.cell)]);
+
+    const int tx = t % width_, ty = t / width_;
+    auto h = [&](int cell) { return std::abs(cell % width_ - tx) + std::abs(cell / width_ - ty); };
+
+    // стан пошуку лежить просто у вузлах; stamp_ відрізняє поточний запит
+    ++stamp_;
+    struct Open { int f, g, k, i; };   // k = -1 — ціль
+    auto worse = [](const Open& a, const Open& b) {
+        return a.f != b.f ? a.f > b.f : a.g < b.g;
+    };
+    std::priority_queue<Open, std::vector<Open>, decltype(worse)> open(worse);
+
+    int goalG = -1, goalParent = Start;
+
+    auto relax = [&](int k, int i, int g, int parent) {
+        if (k < 0) {
+            if (goalG >= 0 && goalG <= g) return;
+            goalG = g;
+            goalParent = parent;
+            open.push({ g, g, -1, 0 });
+            return;
+        }
+        Node& n = clusters_[k].nodes[i];
+        if (n.stamp == stamp_ && n.g <= g) return;
+        n.stamp = stamp_;
+        n.g = g;
+        n.parent = parent;
+        n.closed = false;
+        open.push({ g + h(n.cell), g, k, i });
+    };
+
+    const Cluster& start = clusters_[ks];
+    for (size_t i = 0; i < start.nodes.size(); ++i)
+        if (fromStart[i] >= 0) relax(ks, (int)i, fromStart[i], Start);
+    if (direct >= 0) relax(Goal, 0, direct, Start);
+
+    while (!open.empty()) {
+        Open cur = open.top();
+        open.pop();
+
+        if (cur.k < 0) {
+            if (cur.g != goalG) continue;
+            if (points) {
+                points->clear();
+                points->push_back(t);
+                for (int c = goalParent; c != Start;) {
+                    points->push_back(c);
+                    const Cluster& owner = clusters_[clusterOf(c)];
+                    c = owner.nodes[nodeIndex(owner, c)].parent;
+                }
+                points->push_back(s);
+                std::reverse(points->begin(), points->end());
+            }
+            return goalG;
+        }
+
+        Cluster& c = clusters_[cur.k];
+        Node& node = c.nodes[cur.i];
+        if (node.closed || node.g < cur.g) continue;
+        node.closed = true;
+
+        const int i = cur.i;
+        const size_t n = c.nodes.size();
+
+        if (cur.k == kt && toGoal[i] >= 0) relax(Goal, 0, cur.g + toGoal[i], node.cell);
+
+        for (size_t j = 0; j < n; ++j) {
+            int d = c.dist[i * n + j];
+            if (d > 0) relax(cur.k, (int)j, cur.g + d, node.cell);
+        }
+        for (int p = 0; p < node.partnerCount; ++p) {
+            int other = node.partners[p];
+            int k = clusterOf(other);
+            relax(k, nodeIndex(ensure(k), other), cur.g + 1, node.cell);
+        }
+    }
+    return -1;
+}
+
+// Сусідні точки — перехід через межу; решта лежать в одному кластері
+// і з'єднуються спуском за BFS від наступної точки
+void ClusterGraph::refine(const std::vector<int>& points, std::vector<std::pair<int,int>>& cells) {
+    const int dx[4] = { 0, 0, -1, 1 };
+    const int dy[4] = { -1, 1, 0, 0 };
+
+    cells.emplace_back(points[0] % width_, points[0] / width_);
+    for (size_t p = 1; p < points.size(); ++p) {
+        int a = points[p - 1], b = points[p];
+        if (a == b) continue;
+        const int k = clusterOf(a);
+        if (clusterOf(b) != k) {
+            cells.emplace_back(b % width_, b / width_);
+            continue;
+        }
+
+        localBfs(k, b);
+        const int x0 = (k % cols_) * size_, y0 = (k / cols_) * size_;
+        const int x1 = std::min(width_, x0 + size_), y1 = std::min(height_, y0 + size_);
+
+        int x = a % width_, y = a / width_;
+        while (x != b % width_ || y != b / width_) {
+            int d = local_[localIndex(k, y * width_ + x)];
+            for (int i = 0; i < 4; ++i) {
+                int nx = x + dx[i], ny = y + dy[i];
+                if (nx < x0 || ny < y0 || nx >= x1 || ny >= y1) continue;
+                if (local_[localIndex(k, ny * width_ + nx)] != d - 1) continue;
+                x = nx;
+                y = ny;
+                break;
+            }
+            cells.emplace_back(x, y);
+        }
+    }
+}
+
+bool ClusterGraph::connected(const Level& lvl, int sx, int sy, int tx, int ty) const {
+    if (!lvl.isInside(sx, sy) || !lvl.isInside(tx, ty) || lvl.isWall(sx, sy) || lvl.isWall(tx, ty))
+        return false;
+    // без цієї перевірки A* обійшов би (і побудував) усі кластери компоненти
+    return lvl.componentAt(sx, sy) == lvl.componentAt(tx, ty);
+}
+
+int ClusterGraph::distance(const Level& lvl, int sx, int sy, int tx, int ty) {
+    if (!connected(lvl, sx, sy, tx, ty)) return -1;
+    if (sx == tx && sy == ty) return 0;
+
+    sync(lvl);
+    return search(sy * width_ + sx, ty * width_ + tx, nullptr);
+}
+
+std::vector<std::pair<int,int>> ClusterGraph::path(const Level& lvl, int sx, int sy, int tx, int ty) {
+    std::vector<std::pair<int,int>> cells;
+    if (!connected(lvl, sx, sy, tx, ty)) return cells;
+
+    sync(lvl);
+    std::vector<int> points{ sy * width_ + sx };
+    if ((sx != tx || sy != ty) && search(points[0], ty * width_ + tx, &points) < 0) return cells;
+    refine(points, cells);
+    return cells;
+}
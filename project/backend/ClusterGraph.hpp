@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Level.hpp"
+
+// Ієрархічний пошук шляхів (HPA*). Карта ділиться на квадратні кластери;
+// на кожній межі сусідніх кластерів вільні проходи стають входами — парами
+// клітинок по обидва боки межі. Усередині кластера відстані між входами
+// пораховані BFS наперед, тож запит — короткі BFS від кінців у їхніх
+// кластерах і A* по графу входів. Шлях близький до найкоротшого, але не
+// завжди найкоротший: між кластерами він іде лише через входи.
+// Кластери будуються ліниво, нова стіна скидає лише свій кластер (і
+// сусіда, якщо стіна на спільній межі); інша розкладка скидає все.
+// Не потокобезпечний: один граф на обробник запитів.
+class ClusterGraph {
+public:
+    explicit ClusterGraph(int clusterSize = 16);
+
+    // довжина знайденого шляху; -1 — недосяжно або клітинка поза картою/у стіні
+    int distance(const Level& lvl, int sx, int sy, int tx, int ty);
+
+    // клітинки шляху від (sx, sy) до (tx, ty) включно; порожній — недосяжно
+    std::vector<std::pair<int,int>> path(const Level& lvl, int sx, int sy, int tx, int ty);
+
+    int clusterSize() const { return size_; }
+    size_t clustersBuilt() const;
+    size_t rebuilds() const { return rebuilds_; }
+
+    void clear();
+
+private:
+    struct Node {
+        int cell;                     // y*W + x
+        int partners[2];              // клітинки по той бік межі (кутова — до двох)
+        int partnerCount;
+
+        // стан A*, дійсний лише при stamp == stamp_
+        uint32_t stamp;
+        int g;
+        int parent;                   // клітинка попереднього вузла
+        bool closed;
+    };
+
+    struct Cluster {
+        bool built = false;
+        std::vector<Node> nodes;
+        std::vector<int32_t> dist;    // nodes² відстаней усередині кластера, -1 — немає
+    };
+
+    int size_;
+    uint64_t layout_ = 0;
+    size_t wallsSeen_ = 0;
+    int width_ = 0, height_ = 0;
+    int cols_ = 0, rows_ = 0;
+    size_t rebuilds_ = 0;
+    uint32_t stamp_ = 0;
+
+    const Level* lvl_ = nullptr;
+    std::vector<Cluster> clusters_;
+
+    std::vector<int32_t> local_;      // відстані останнього BFS у кластері
+    std::vector<int> queue_;
+
+    bool connected(const Level& lvl, int sx, int sy, int tx, int ty) const;
+    void sync(const Level& lvl);
+    void wallAdded(int x, int y);
+
+    int clusterOf(int cell) const;
+    Cluster& ensure(int k);
+    void rebuild(int k);
+    void addTransitions(Cluster& c, int ax, int ay, int bx, int by, int len, int stepX, int stepY);
+    int nodeIndex(const Cluster& c, int cell) const;
+
+    // BFS у межах кластера k від клітинки cell → local_
+    void localBfs(int k, int cell);
+    int localIndex(int k, int cell) const;
+
+    // вузли абстрактного шляху (старт, входи, ціль) і його довжина
+    int search(int s, int t, std::vector<int>* points);
+    void refine(const std::vector<int>& points, std::vector<std::pair<int,int>>& cells);
+};
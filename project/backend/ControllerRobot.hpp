@@ -7,12 +7,15 @@ public:
     ControllerRobot() = default;
 
     RobotType getType() const override { return RobotType::Controller; }
+    std::unique_ptr<Robot> clone() const override { return std::make_unique<ControllerRobot>(*this); }
 
     void execute(const Command& cmd, WorldView& w) override;
 
     void setCommand(const Command& cmd);
 
     bool hasPendingCommand() const { return pendingCommand.has_value(); }
+    const std::optional<Command>& getPendingCommand() const { return pendingCommand; }
+    void clearPendingCommand() { pendingCommand.reset(); }
     Command takePendingCommand() {
         Command c = pendingCommand.value();
         pendingCommand.reset();
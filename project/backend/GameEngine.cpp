@@ -1,15 +1,297 @@
 #include "GameEngine.hpp"
 #include "WorkerRobot.hpp"
 #include "ControllerRobot.hpp"
-#include <queue>
+#include "Hash.hpp"
+#include "BitboardEngine.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <tuple>
+#include <climits>
+#include <cstdio>
 
 using json = nlohmann::json;
 
-GameEngine::GameEngine() : level(10, 10) {}
-bool running_= false;
+// скільки 64-бітних слів на бітборд карти; 0 — карта завелика
+static int bitboardWordsFor(const Level& lvl) {
+    long cells = (long)lvl.getWidth() * lvl.getHeight();
+    return cells <= 64 ? 1 : cells <= 128 ? 2 : cells <= 256 ? 4 : 0;
+}
+
+GameEngine::GameEngine() : level(10, 10) {
+    pristine_ = std::make_shared<const LevelSnapshot>(level.snapshot());
+    bitboardWords_ = bitboardWordsFor(level);
+    rehash();
+}
 
 void GameEngine::loadLevel(Level&& lvl) {
     level = std::move(lvl);
+    bitboardWords_ = bitboardWordsFor(level);
+    running_ = false;
+    locked_ = false;
+    pristine_ = std::make_shared<const LevelSnapshot>(level.snapshot());
+    started_.reset();
+    history_.clear();
+    trace_.clear();
+    manualCommands_ = false;
+    rehash();
+}
+
+void GameEngine::restoreState(const LevelSnapshot& snap, bool running,
+                              const LevelSnapshot* started)
+{
+    level.restore(snap);
+    running_ = running;
+    started_ = started ? std::make_shared<const LevelSnapshot>(*started) : nullptr;
+    history_.clear();
+    trace_.clear();
+    rehash();
+}
+
+void GameEngine::reset() {
+    level.restore(*pristine_);
+    running_ = false;
+    locked_ = false;
+    started_.reset();
+    history_.clear();
+    trace_.clear();
+    manualCommands_ = false;
+    rehash();
+}
+
+void GameEngine::resetKeepPlacements() {
+    if (started_) level.restore(*started_);
+    running_ = false;
+    locked_ = false;
+    history_.clear();
+    manualCommands_ = false;
+    rehash();
+}
+
+size_t GameEngine::undo(size_t n) {
+    if (n == 0 || history_.size() == 0) return 0;
+
+    // дельти відкочуються на місці, від останньої
+    TickDelta d;
+    size_t undone = 0;
+
+    while (undone < n && history_.pop(d)) {
+        level.revert(d);
+        running_ = d.wasRunning;
+        ++undone;
+    }
+
+    trace_.clear();
+    rehash();
+    return undone;
+}
+
+void GameEngine::beginDelta(bool wasRunning) {
+    scratch_.recording = history_.depth() > 0;
+    if (!scratch_.recording) return;
+
+    scratch_.delta.robots.clear();
+    scratch_.delta.boxes.clear();
+    scratch_.delta.commands.clear();
+    scratch_.delta.removed.clear();
+    scratch_.delta.movesBefore = level.getMoves();
+    scratch_.delta.wasRunning = wasRunning;
+
+    // номер запису переповнився — старі позначки вже не відрізнити
+    if (++scratch_.mark == 0) {
+        std::fill(scratch_.robotMarks.begin(), scratch_.robotMarks.end(), 0);
+        std::fill(scratch_.boxMarks.begin(), scratch_.boxMarks.end(), 0);
+        scratch_.mark = 1;
+    }
+}
+
+void GameEngine::noteRobot(const RobotState* s) {
+    if (!scratch_.recording || !s) return;
+
+    // індекс стану; зазвичай id - 1
+    auto& states = level.getRobotStates();
+    size_t idx = (size_t)(s->id - 1);
+    if (idx >= states.size() || states[idx].get() != s) {
+        for (idx = 0; idx < states.size(); ++idx)
+            if (states[idx].get() == s) break;
+        if (idx == states.size()) return;
+    }
+
+    if (scratch_.robotMarks.size() < states.size()) scratch_.robotMarks.resize(states.size(), 0);
+    if (scratch_.robotMarks[idx] == scratch_.mark) return;
+    scratch_.robotMarks[idx] = scratch_.mark;
+    scratch_.delta.robots.push_back({ (uint32_t)idx, *s });
+}
+
+void GameEngine::noteRobotId(int id) {
+    if (!scratch_.recording) return;
+
+    auto& states = level.getRobotStates();
+    size_t idx = (size_t)(id - 1);
+    if (idx < states.size() && states[idx]->id == id) { noteRobot(states[idx].get()); return; }
+    for (auto& st : states)
+        if (st->id == id) { noteRobot(st.get()); return; }
+}
+
+void GameEngine::noteBox(int boxId) {
+    if (!scratch_.recording) return;
+
+    auto& boxes = level.getBoxes();
+    size_t idx = (size_t)(boxId - 1);
+    if (idx >= boxes.size() || boxes[idx].id != boxId) {
+        for (idx = 0; idx < boxes.size(); ++idx)
+            if (boxes[idx].id == boxId) break;
+        if (idx == boxes.size()) return;
+    }
+
+    if (scratch_.boxMarks.size() < boxes.size()) scratch_.boxMarks.resize(boxes.size(), 0);
+    if (scratch_.boxMarks[idx] == scratch_.mark) return;
+    scratch_.boxMarks[idx] = scratch_.mark;
+    scratch_.delta.boxes.push_back({ (uint32_t)idx, boxes[idx] });
+}
+
+void GameEngine::noteCommand(bool placed, size_t position, const Command& before) {
+    if (scratch_.recording) scratch_.delta.commands.push_back({ placed, (uint32_t)position, before });
+}
+
+// мертві роботи прибираються зі списку; в історію — позиція в списку
+// на момент прибирання, щоб undo вставив робота на те саме місце
+void GameEngine::sweepDead(std::vector<std::unique_ptr<Robot>>& list, bool placed) {
+    size_t out = 0;
+    for (size_t i = 0; i < list.size(); ++i) {
+        const RobotState* s = list[i]->getState();
+        if (!s || s->alive) {
+            if (out != i) list[out] = std::move(list[i]);
+            ++out;
+            continue;
+        }
+
+        if (scratch_.recording) {
+            auto& states = level.getRobotStates();
+            size_t idx = (size_t)(s->id - 1);
+            if (idx >= states.size() || states[idx].get() != s)
+                for (idx = 0; idx < states.size() && states[idx].get() != s; ++idx) {}
+
+            TickDelta::Removal rm{ placed, (uint32_t)out, (uint32_t)idx };
+            if (auto* c = dynamic_cast<const ControllerRobot*>(list[i].get())) {
+                if (c->hasPendingCommand()) {
+                    rm.hasCommand = true;
+                    rm.command = *c->getPendingCommand();
+                }
+            }
+            scratch_.delta.removed.push_back(rm);
+        }
+    }
+    list.resize(out);
+}
+
+void GameEngine::endDelta() {
+    if (scratch_.recording) history_.push(scratch_.delta);
+    scratch_.recording = false;
+}
+
+// ===== ZOBRIST =====
+// Ключі не зберігаються в таблиці, а обчислюються перемішуванням ознак
+// (id, клітинка, напрямок, вантаж, команда) — це рівносильно випадковій
+// таблиці, але не залежить від розміру карти.
+
+uint64_t GameEngine::robotKeyOf(const RobotState& s, const Command* pending) {
+    if (!s.alive) return 0;
+
+    uint64_t f = (uint64_t)(uint32_t)s.id;
+    f = f * 0x10000 + (uint16_t)s.x;
+    f = f * 0x10000 + (uint16_t)s.y;
+    f = f * 8 + (uint64_t)s.dir * 2 + (s.type == RobotType::Worker ? 1 : 0);
+
+    uint64_t k = splitmix64(f ^ 0x5a17ull);
+    k = splitmix64(k ^ (uint64_t)(s.carrying ? 1 + (uint32_t)s.boxId.value_or(0) : 0));
+
+    if (pending)
+        k = splitmix64(k ^ (0xc0de0000ull + (uint64_t)pending->type));
+    return k;
+}
+
+uint64_t GameEngine::boxKeyOf(const Box& b) {
+    uint64_t f = (uint64_t)(uint32_t)b.id;
+    f = f * 0x10000 + (uint16_t)b.x;
+    f = f * 0x10000 + (uint16_t)b.y;
+    f = f * 2 + (b.delivered ? 1 : 0);
+    return splitmix64(f ^ 0xb0c5ull);
+}
+
+uint64_t GameEngine::robotKey(const Robot& r) const {
+    const RobotState* s = r.getState();
+    if (!s) return 0;
+
+    const Command* pending = nullptr;
+    if (auto* c = dynamic_cast<const ControllerRobot*>(&r))
+        if (c->hasPendingCommand()) pending = &*c->getPendingCommand();
+    return robotKeyOf(*s, pending);
+}
+
+uint64_t GameEngine::boxKey(int boxId) const {
+    auto& boxes = level.getBoxes();
+
+    size_t idx = (size_t)(boxId - 1);
+    if (idx < boxes.size() && boxes[idx].id == boxId) return boxKeyOf(boxes[idx]);
+    for (auto& x : boxes) if (x.id == boxId) return boxKeyOf(x);
+    return 0;
+}
+
+uint64_t GameEngine::computeStateHash() const {
+    uint64_t h = 0;
+    for (auto& r : level.getRobots()) h ^= robotKey(*r);
+    for (auto& r : level.getPlacedRobots()) h ^= robotKey(*r);
+    for (auto& b : level.getBoxes()) h ^= boxKey(b.id);
+    return h;
+}
+
+void GameEngine::rehash() {
+    hash_ = computeStateHash();
+    forgetSeen();
+    hopeless_ = computeHopeless();
+}
+
+// бачені стани діють, лише поки світ детермінований: після ручних команд
+// і відкатів повтор старого стану вже не означає циклу
+void GameEngine::forgetSeen() {
+    nonTerminating_ = false;
+    seen_.clear();
+    ++seenEpoch_;
+}
+
+void GameEngine::restoreRun(bool manualCommands, bool nonTerminating, const std::vector<uint64_t>& seen) {
+    manualCommands_ = manualCommands;
+    nonTerminating_ = nonTerminating;
+    for (uint64_t h : seen) seen_.insert(h);
+    hopeless_ = computeHopeless();
+}
+
+// Level::update з інкрементним оновленням хешу: змінюються лише роботи
+// у стіні або з вантажем на цілі
+void GameEngine::updateLevel() {
+    struct Touched { Robot* r; int box; };
+    std::vector<Touched> touched;
+
+    for (auto& r : level.getRobots()) {
+        auto* st = r->getState();
+        if (!st || !st->alive || !level.isInside(st->x, st->y)) continue;
+
+        bool wall = level.isWall(st->x, st->y);
+        bool deliver = st->type == RobotType::Worker && st->carrying && st->boxId &&
+                       level.isTarget(st->x, st->y);
+        if (!wall && !deliver) continue;
+
+        int box = st->carrying && st->boxId ? *st->boxId : 0;
+        touched.push_back({ r.get(), box });
+        hash_ ^= robotKey(*r) ^ (box ? boxKey(box) : 0);
+        noteRobot(st);
+        if (box) noteBox(box);
+    }
+
+    level.update();
+
+    for (auto& t : touched)
+        hash_ ^= robotKey(*t.r) ^ (t.box ? boxKey(t.box) : 0);
 }
 
 static std::string dirToStr(Direction d) {
@@ -32,42 +314,73 @@ void GameEngine::spawnPlacedRobot(int x, int y, const std::string& type) {
 
     r->setPosition(x, y);
     level.getPlacedRobots().push_back(std::move(r));
+    trace_.clear();
 }
 
 void GameEngine::commitPlacedRobots() {
     for (auto& r : level.getPlacedRobots())
         level.addRobot(std::move(r));
     level.getPlacedRobots().clear();
+    trace_.clear();
 }
 
 void GameEngine::clearPlacedRobots() {
     level.getPlacedRobots().clear();
+    trace_.clear();
 }
 
+// розставлені гравцем роботи теж керовані: plan_paths планує й для них
 Robot* GameEngine::findRobotById(int id) {
-    for (auto& r : level.getRobots()) {
-        if (r->getState() && r->getState()->id == id)
-            return r.get();
-    }
+    for (auto* arr : { &level.getRobots(), &level.getPlacedRobots() })
+        for (auto& r : *arr)
+            if (r->getState() && r->getState()->id == id)
+                return r.get();
     return nullptr;
 }
 
 void GameEngine::applyCommands(const std::vector<Command>& cmds) {
+    beginDelta(running_);
+    const uint64_t hashBefore = hash_;
+
     WorldView view{
         level.getWidth(),
         level.getHeight(),
         &level.getGridCells(),
         &level.getRobotStates(),
-        &level.getBoxes()
+        &level.getBoxes(),
+        &level.getRayTable()
     };
 
     for (auto& c : cmds) {
         Robot* r = findRobotById(c.robotId);
-        if (r) r->execute(c, view);
+        if (!r) continue;
+
+        auto* st = r->getState();
+        int box = st && st->carrying && st->boxId ? *st->boxId : 0;
+
+        // робітник змінює себе й свій вантаж, контролер — робота за id
+        if (dynamic_cast<ControllerRobot*>(r)) noteRobotId(c.robotId);
+        else noteRobot(st);
+        if (box) noteBox(box);
+
+        hash_ ^= robotKey(*r) ^ (box ? boxKey(box) : 0);
+        r->execute(c, view);
+
+        // контролер може повернути будь-якого робота за id
+        if (dynamic_cast<ControllerRobot*>(r))
+            hash_ = computeStateHash();
+        else
+            hash_ ^= robotKey(*r) ^ (box ? boxKey(box) : 0);
     }
 
     level.incrementMoves();
-    level.update();
+    updateLevel();
+    trace_.clear();
+    manualCommands_ = true;
+    if (hash_ != hashBefore) forgetSeen();
+    hopeless_ = computeHopeless();
+
+    endDelta();
 }
 
 json GameEngine::getStateJson() const {
@@ -109,27 +422,382 @@ json GameEngine::getStateJson() const {
     append(level.getRobots());
     append(level.getPlacedRobots());
 
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash_);
+    st["hash"] = hex;
+
     return {
     {"state", st},
-    {"finished", isWin() || isLose()},
-    {"win", isWin()}
+    {"finished", isFinished()},
+    {"win", isWin()},
+    {"non_terminating", nonTerminating_}
 };
 }
 
 
 void GameEngine::update() {
-    level.update();
+    updateLevel();
 }
 
 void GameEngine::addRobot(std::unique_ptr<Robot> r) {
     level.addRobot(std::move(r));
+    trace_.clear();
+    rehash();
 }
 
 void GameEngine::addPlacedRobot(std::unique_ptr<Robot> r) {
     level.addPlacedRobot(std::move(r));
+    trace_.clear();
+    rehash();
+}
+
+// ===== ПРАВКА РОЗСТАНОВКИ =====
+
+bool GameEngine::editPlacement(int id, int x, int y, Direction dir,
+                               std::optional<CommandType> command)
+{
+    if (running_) return false;
+
+    Robot* robot = nullptr;
+    for (auto& r : level.getPlacedRobots())
+        if (r->getState() && r->getState()->id == id) { robot = r.get(); break; }
+    if (!robot) return false;
+
+    RobotState* s = robot->getState();
+    auto front = [](int cx, int cy, Direction d) {
+        switch (d) {
+            case Direction::Up:    --cy; break;
+            case Direction::Down:  ++cy; break;
+            case Direction::Left:  --cx; break;
+            case Direction::Right: ++cx; break;
+        }
+        return std::make_pair(cx, cy);
+    };
+
+    const std::pair<int,int> cells[4] = {
+        { s->x, s->y }, front(s->x, s->y, s->dir), { x, y }, front(x, y, dir)
+    };
+
+    // Контролер нерухомий і діє лише на клітинку перед собою, тож поки
+    // жоден робітник не підійшов до старої чи нової клітинки, прогін той самий.
+    // Робітник рушає з першого ходу — лише з нуля.
+    int limit = 0;
+    if (s->type == RobotType::Controller && trace_.valid()) {
+        limit = INT_MAX;
+        for (auto& c : cells) limit = std::min(limit, trace_.firstNear(c.first, c.second));
+
+        // інші контролери стоять на місці: сусідство з ними діє одразу
+        auto touches = [&](const std::vector<std::unique_ptr<Robot>>& arr) {
+            for (auto& r : arr) {
+                auto* o = r->getState();
+                if (!o || o == s || !o->alive || o->type != RobotType::Controller) continue;
+
+                auto of = front(o->x, o->y, o->dir);
+                for (auto& c : cells)
+                    if ((o->x == c.first && o->y == c.second) || of == c) return true;
+            }
+            return false;
+        };
+        if (touches(level.getRobots()) || touches(level.getPlacedRobots())) limit = 0;
+    }
+
+    s->x = x;
+    s->y = y;
+    s->dir = dir;
+    robot->setPosition(x, y);
+    robot->setDirection(dir);
+
+    if (command) {
+        if (auto* c = dynamic_cast<ControllerRobot*>(robot)) {
+            Command C{};
+            C.type = *command;
+            C.dir = dir;
+            c->setCommand(C);
+        }
+    }
+
+    trace_.noteEdit(id, limit);
+    history_.clear();
+    rehash();
+    return true;
+}
+
+int GameEngine::resumeFromTrace() {
+    if (!trace_.resumePoint()) return 0;
+
+    auto placement = std::make_shared<const LevelSnapshot>(level.snapshot());
+    const RunTrace::Checkpoint* cp = trace_.rebase(*placement);
+
+    level.restore(cp->snap);
+    running_ = true;
+    started_ = placement;
+    history_.clear();
+    rehash();
+
+    // нова розстановка могла зробити прогін безнадійним раніше: тоді
+    // продовжуємо з останнього знімка, де поразки ще не було
+    while (isLose()) {
+        cp = trace_.retreat();
+        if (!cp) {
+            level.restore(*placement);
+            running_ = false;
+            started_.reset();
+            rehash();
+            return 0;
+        }
+        level.restore(cp->snap);
+        rehash();
+    }
+    return cp->tick;
+}
+
+GameEngine::RunResult GameEngine::runUntilFinished(int maxTicks) {
+    RunResult res;
+    if (!running_) res.ticks = res.resumedFrom = resumeFromTrace();
+
+    res.ticks += runBitboard(maxTicks - res.ticks);
+    while (res.ticks < maxTicks && !isFinished())
+        res.ticks += advance(maxTicks - res.ticks);
+
+    res.win = isWin();
+    res.lose = isLose();
+    res.nonTerminating = nonTerminating_;
+    return res;
+}
+
+// Прогін на бітбордах, поки стан ними підтримується; стан, на якому
+// бітбордовий рушій зупинився, переноситься сюди — далі звичайні ходи.
+// Історія і знімки сліду ведуться по ходах, тож із ними — лише звичайні.
+int GameEngine::runBitboard(int maxTicks) {
+    if (!bitboardWords() || !fastForward_ || history_.depth() > 0 || trace_.interval() > 0)
+        return 0;
+
+    int ticks = 0;
+    withBitboardEngine(*this, [&](auto& bb) {
+        while (ticks < maxTicks && !bb.isFinished()) {
+            int k = bb.advance(maxTicks - ticks);
+            if (k == 0) break;
+            ticks += k;
+        }
+        if (ticks > 0) {
+            bb.store(*this);
+            nonTerminating_ = bb.isNonTerminating();
+        }
+    });
+    return ticks;
+}
+
+// ===== ПЕРЕМОТКА =====
+// Між подіями (зіткнення, смерть, підбір, здача, спрацювання контролера)
+// кожен робітник просто йде прямо. Такі ходи можна пропустити одним
+// стрибком, якщо відомо, скільки їх буде.
+
+static std::pair<int,int> dirDelta(Direction d) {
+    switch (d) {
+        case Direction::Up:    return {0, -1};
+        case Direction::Down:  return {0, 1};
+        case Direction::Left:  return {-1, 0};
+        case Direction::Right: return {1, 0};
+    }
+    return {0, 0};
+}
+
+// Перший хід t у [0, limit), на початку якого два роботи ближчі за 3 клітинки
+// (манхеттенська відстань |d + t*v| <= 2). Відстань опукла за t, тож
+// мінімум шукаємо у зламах, а перший такий хід — двійковим пошуком.
+static int firstNear(long long ax, long long ay, long long vx, long long vy, int limit) {
+    auto dist = [&](long long t) {
+        return std::llabs(ax + t * vx) + std::llabs(ay + t * vy);
+    };
+    if (dist(0) <= 2) return 0;
+
+    long long best = 0;
+    auto consider = [&](long long t) {
+        t = std::max(0LL, std::min<long long>(t, limit - 1));
+        if (dist(t) < dist(best)) best = t;
+    };
+    consider(limit - 1);
+    if (vx != 0) { consider(-ax / vx); consider(-ax / vx + 1); }
+    if (vy != 0) { consider(-ay / vy); consider(-ay / vy + 1); }
+
+    if (dist(best) > 2) return limit;
+
+    long long lo = 0, hi = best;   // dist(lo) > 2, dist(hi) <= 2
+    while (hi - lo > 1) {
+        long long mid = (lo + hi) / 2;
+        if (dist(mid) <= 2) hi = mid; else lo = mid;
+    }
+    return (int)hi;
+}
+
+int GameEngine::quietTicks(int limit) const {
+    if (limit <= 0) return 0;
+
+    struct Body {
+        const Robot* r;
+        const RobotState* s;
+        int dx, dy;
+    };
+    std::vector<Body> bodies;
+
+    auto collect = [&](const std::vector<std::unique_ptr<Robot>>& arr, bool updated) {
+        for (auto& r : arr) {
+            const RobotState* s = r->getState();
+            if (!s) continue;
+            // мертвий у списку ще може бути ціллю контролера чи перешкодою
+            if (!s->alive) return false;
+            // Level::update вб'є робота в стіні
+            if (updated && level.isWall(s->x, s->y)) return false;
+
+            Body b{ r.get(), s, 0, 0 };
+            if (s->type == RobotType::Worker)
+                std::tie(b.dx, b.dy) = dirDelta(s->dir);
+            bodies.push_back(b);
+        }
+        return true;
+    };
+    if (!collect(level.getRobots(), true) || !collect(level.getPlacedRobots(), false))
+        return 0;
+
+    int k = limit;
+
+    // незайняті коробки лежать на місці
+    std::vector<const Box*> loose;
+    for (auto& b : level.getBoxes()) {
+        if (b.delivered) continue;
+        bool carried = false;
+        for (auto& body : bodies)
+            if (body.s->carrying && body.s->boxId == b.id) { carried = true; break; }
+        if (!carried) loose.push_back(&b);
+    }
+
+    // робітник: межа, стіна (таблиця променів), коробка (без вантажу)
+    // або ціль (з вантажем) на шляху
+    for (auto& b : bodies) {
+        if (b.dx == 0 && b.dy == 0) continue;
+        const RobotState* s = b.s;
+
+        // скільки клітинок попереду вільні
+        int reach = level.isInside(s->x, s->y) ? level.rayDistance(s->x, s->y, s->dir) : 0;
+
+        auto clip = [&](int x, int y) {
+            int ox = x - s->x, oy = y - s->y;
+            int steps = b.dx ? ox * b.dx : oy * b.dy;
+            bool onRay = (b.dx ? oy == 0 : ox == 0) && steps > 0;
+            if (onRay) reach = std::min(reach, steps - 1);
+        };
+
+        if (s->carrying) {
+            for (auto& t : level.getTargets()) clip(t.first, t.second);
+        } else {
+            for (const Box* box : loose) clip(box->x, box->y);
+        }
+
+        k = std::min(k, reach);
+        if (k == 0) return 0;
+    }
+
+    // пари роботів: зіткнення або спрацювання контролера можливі лише поруч
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        for (size_t j = i + 1; j < bodies.size(); ++j) {
+            const Body& a = bodies[i];
+            const Body& b = bodies[j];
+
+            if (a.dx == b.dx && a.dy == b.dy) {
+                // взаємне розташування не змінюється: або подія вже зараз,
+                // або її не буде (два контролери, робітники пліч-о-пліч)
+                auto touches = [](const Body& p, const Body& o) {
+                    int fx = p.dx, fy = p.dy;
+                    if (fx == 0 && fy == 0) {
+                        auto* ctrl = dynamic_cast<const ControllerRobot*>(p.r);
+                        if (!ctrl || !ctrl->hasPendingCommand()) return false;
+                        std::tie(fx, fy) = dirDelta(p.s->dir);
+                    }
+                    return o.s->x == p.s->x + fx && o.s->y == p.s->y + fy;
+                };
+                if (touches(a, b) || touches(b, a)) return 0;
+                continue;
+            }
+
+            k = firstNear(a.s->x - b.s->x, a.s->y - b.s->y,
+                          a.dx - b.dx, a.dy - b.dy, k);
+            if (k == 0) return 0;
+        }
+    }
+
+    return k;
+}
+
+void GameEngine::jump(int ticks) {
+    beginDelta(true);
+
+    seen_.insert(hash_);
+
+    auto shift = [&](std::vector<std::unique_ptr<Robot>>& arr) {
+        for (auto& r : arr) {
+            RobotState* s = r->getState();
+            if (!s || s->type != RobotType::Worker) continue;
+
+            noteRobot(s);
+            auto [dx, dy] = dirDelta(s->dir);
+            s->x += ticks * dx;
+            s->y += ticks * dy;
+
+            if (s->carrying && s->boxId) {
+                noteBox(*s->boxId);
+                for (auto& b : level.getBoxes())
+                    if (b.id == *s->boxId) { b.x = s->x; b.y = s->y; break; }
+            }
+        }
+    };
+    shift(level.getRobots());
+    shift(level.getPlacedRobots());
+    level.addMoves(ticks);
+
+    hash_ = computeStateHash();
+    if (!seen_.insert(hash_))
+        nonTerminating_ = true;
+    hopeless_ = computeHopeless();
+
+    trace_.advance(ticks, level);
+
+    // стрибок у історії — один запис: undo повертає його цілком
+    endDelta();
+}
+
+int GameEngine::advance(int maxTicks) {
+    if (maxTicks <= 0) return 0;
+
+    int k = (running_ && fastForward_) ? quietTicks(maxTicks) : 0;
+
+    // під час тихих ходів надії лише меншає: шукаємо перший безнадійний
+    if (k >= 2 && !hopeless_ && computeHopeless(k)) {
+        int lo = 0, hi = k;   // computeHopeless(lo) == false, computeHopeless(hi) == true
+        while (hi - lo > 1) {
+            int mid = (lo + hi) / 2;
+            if (computeHopeless(mid)) hi = mid; else lo = mid;
+        }
+        k = hi;
+    }
+
+    if (k < 2) {
+        stepAuto();
+        return 1;
+    }
+
+    jump(k);
+    return k;
 }
 
 void GameEngine::stepAuto() {
+    beginDelta(running_);
+
+    // розстановка гравця фіксується перед першим кроком
+    if (!running_) {
+        started_ = std::make_shared<const LevelSnapshot>(level.snapshot());
+        trace_.begin(level);
+    }
+    seen_.insert(hash_);
     running_ = true;
     //if (locked_) return;
 
@@ -137,7 +805,7 @@ void GameEngine::stepAuto() {
     auto& placed = level.getPlacedRobots();
 
     // ===== КОНТРОЛЕРИ =====
-    auto controllerAction = [&](Robot* base){
+    auto controllerAction = [&](Robot* base, bool isPlaced, size_t position){
         ControllerRobot* c = dynamic_cast<ControllerRobot*>(base);
         if (!c) return;
 
@@ -161,37 +829,56 @@ void GameEngine::stepAuto() {
                 if (!s) continue;
 
                 if (s->x == tx && s->y == ty) {
+                    // команда Move зрушує й вантаж робітника
+                    int box = s->carrying && s->boxId ? *s->boxId : 0;
+                    hash_ ^= robotKey(*c) ^ robotKey(*r) ^ (box ? boxKey(box) : 0);
+                    noteCommand(isPlaced, position, *c->getPendingCommand());
                     Command cmd = c->takePendingCommand();
 
+                    if (dynamic_cast<ControllerRobot*>(r.get())) {
+                        noteRobotId(cmd.robotId);
+                    } else {
+                        noteRobot(s);
+                        if (s->carrying && s->boxId) noteBox(*s->boxId);
+                    }
+
                     WorldView view{
                         level.getWidth(),
                         level.getHeight(),
                         &level.getGridCells(),
                         &level.getRobotStates(),
-                        &level.getBoxes()
+                        &level.getBoxes(),
+                        &level.getRayTable()
                     };
 
                     r->execute(cmd, view);
+
+                    // контролер може повернути будь-якого робота за id
+                    if (dynamic_cast<ControllerRobot*>(r.get()))
+                        hash_ = computeStateHash();
+                    else
+                        hash_ ^= robotKey(*c) ^ robotKey(*r) ^ (box ? boxKey(box) : 0);
                     return;
                 }
             }
         };
 
         apply(robots);
-        apply(placed);
+        if (c->hasPendingCommand()) apply(placed);
     };
 
-    for (auto& r : robots) controllerAction(r.get());
-    for (auto& r : placed) controllerAction(r.get());
+    for (size_t i = 0; i < robots.size(); ++i) controllerAction(robots[i].get(), false, i);
+    for (size_t i = 0; i < placed.size(); ++i) controllerAction(placed[i].get(), true, i);
 
 
     // ===== РУХ WORKER =====
-    auto moveWorker = [&](Robot* base) {
+    auto moveWorkerImpl = [&](Robot* base) {
         WorkerRobot* w = dynamic_cast<WorkerRobot*>(base);
         if (!w) return;
 
         auto* s = w->getState();
         if (!s || !s->alive) return;
+        noteRobot(s);
 
         int dx = 0, dy = 0;
         switch (s->dir) {
@@ -204,14 +891,11 @@ void GameEngine::stepAuto() {
         int nx = s->x + dx;
         int ny = s->y + dy;
 
-        // 1) вихід за межі
-        if (!level.isInside(nx, ny)) {
-            s->alive = false;
-            return;
-        }
-
-        // 2) стіна
-        if (level.getCell(nx, ny).type == CellType::Wall) {
+        // 1-2) вихід за межі або стіна
+        bool blocked = level.isInside(s->x, s->y)
+            ? level.rayDistance(s->x, s->y, s->dir) == 0
+            : !level.isInside(nx, ny) || level.isWall(nx, ny);
+        if (blocked) {
             s->alive = false;
             return;
         }
@@ -251,6 +935,7 @@ void GameEngine::stepAuto() {
             int bid = *s->boxId;
             for (auto& b : level.getBoxes()) {
                 if (b.id == bid) {
+                    noteBox(bid);
                     b.x = nx;
                     b.y = ny;
 
@@ -267,30 +952,57 @@ void GameEngine::stepAuto() {
         }
     };
 
+    // хеш: до і після руху враховуються робот, його вантаж
+    // і перша недоставлена коробка у клітинці попереду
+    auto moveWorker = [&](Robot* base) {
+        auto* s = base->getState();
+        if (!s || !s->alive || s->type != RobotType::Worker) {
+            moveWorkerImpl(base);
+            return;
+        }
+
+        int nx = s->x, ny = s->y;
+        switch (s->dir) {
+            case Direction::Up:    --ny; break;
+            case Direction::Down:  ++ny; break;
+            case Direction::Left:  --nx; break;
+            case Direction::Right: ++nx; break;
+        }
+
+        int carried = s->carrying && s->boxId ? *s->boxId : 0;
+        int ahead = 0;
+        if (!s->carrying) {
+            for (auto& b : level.getBoxes())
+                if (!b.delivered && b.x == nx && b.y == ny) { ahead = b.id; break; }
+        }
+
+        auto keys = [&]() {
+            return robotKey(*base) ^ (carried ? boxKey(carried) : 0) ^ (ahead ? boxKey(ahead) : 0);
+        };
+
+        hash_ ^= keys();
+        moveWorkerImpl(base);
+        hash_ ^= keys();
+    };
+
     // ЗАПУСК РУХУ WORKER 
     for (auto& r : robots) moveWorker(r.get());
     for (auto& r : placed) moveWorker(r.get());
 
     //  ВИДАЛЕННЯ МЕРТВИХ 
-    robots.erase(
-        std::remove_if(robots.begin(), robots.end(),
-            [](const std::unique_ptr<Robot>& r) {
-                auto* s = r->getState();
-                return s && !s->alive;
-            }),
-        robots.end()
-    );
-
-    placed.erase(
-        std::remove_if(placed.begin(), placed.end(),
-            [](const std::unique_ptr<Robot>& r) {
-                auto* s = r->getState();
-                return s && !s->alive;
-            }),
-        placed.end()
-    );
+    sweepDead(robots, false);
+    sweepDead(placed, true);
 
-    level.update();
+    updateLevel();
+
+    // повтор стану означає цикл: детермінований світ далі лише повторюється
+    if (!seen_.insert(hash_))
+        nonTerminating_ = true;
+    hopeless_ = computeHopeless();
+
+    trace_.advance(1, level);
+
+    endDelta();
 }
 
 
@@ -316,45 +1028,27 @@ bool GameEngine::isWin() const {
     return level.isCompleted();
 }
 
-/*bool GameEngine::bfs_reachable(
+// чи з'єднані дві клітинки без стін (4-зв'язність): за областями рівня,
+// без обходу; зі стартової стіни можна вийти в будь-яку сусідню область
+bool GameEngine::bfs_reachable(
     const Level& lvl,
     int sx, int sy,
     const std::pair<int,int>& target)
 {
-    int W = lvl.getWidth();
-    int H = lvl.getHeight();
-
     if (!lvl.isInside(sx, sy)) return false;
+    if (sx == target.first && sy == target.second) return true;
 
-    std::vector<std::vector<char>> used(H, std::vector<char>(W, 0));
-    std::queue<std::pair<int,int>> q;
-    q.push({sx, sy});
-    used[sy][sx] = 1;
+    int goal = lvl.componentAt(target.first, target.second);
+    if (goal < 0) return false;
+
+    if (!lvl.isWall(sx, sy)) return lvl.componentAt(sx, sy) == goal;
 
     const int dx[4] = {1,-1,0,0};
     const int dy[4] = {0,0,1,-1};
-
-    while (!q.empty()) {
-        auto [x, y] = q.front(); q.pop();
-
-        if (x == target.first && y == target.second)
-            return true;
-
-        for (int k=0; k<4; ++k) {
-            int nx = x + dx[k];
-            int ny = y + dy[k];
-
-            if (!lvl.isInside(nx, ny)) continue;
-            if (used[ny][nx]) continue;
-            if (lvl.isWall(nx, ny)) continue;
-
-            used[ny][nx] = 1;
-            q.push({nx, ny});
-        }
-    }
-
+    for (int k = 0; k < 4; ++k)
+        if (lvl.componentAt(sx + dx[k], sy + dy[k]) == goal) return true;
     return false;
-}*/
+}
 
 bool GameEngine::isLose() const {
     // якщо гра ще не запущена — поразки бути не може
@@ -372,6 +1066,9 @@ bool GameEngine::isLose() const {
         return false;
     };
 
+    if (hopeless_)
+        return true;
+
     // перевіряємо всі реальні роботи
     if (hasAliveWorker(level.getRobots()))
         return false;
@@ -383,3 +1080,170 @@ bool GameEngine::isLose() const {
     return true;
 }
 
+// Оптимістична оцінка: false, якщо хоч якийсь розвиток подій може
+// доставити всі коробки. Зіткнення й загибель робітників не враховуються,
+// тож true означає, що перемоги справді не буде.
+// shift — оцінка стану через стільки тихих ходів (див. quietTicks).
+bool GameEngine::computeHopeless(int shift) const {
+    if (!running_ || !earlyLose_) return false;
+
+    HopelessInput in;
+    in.manualCommands = manualCommands_;
+    in.boxes = &level.getBoxes();
+
+    auto collect = [&](const std::vector<std::unique_ptr<Robot>>& arr) {
+        for (auto& r : arr) {
+            const RobotState* s = r->getState();
+            if (!s) continue;
+            if (auto* ctrl = dynamic_cast<const ControllerRobot*>(r.get())) {
+                if (!ctrl->hasPendingCommand()) continue;
+                auto t = ctrl->getPendingCommand()->type;
+                in.rotationsOnly = in.rotationsOnly && (t == CommandType::RotateCW || t == CommandType::RotateCCW);
+                auto [dx, dy] = dirDelta(s->dir);
+                in.fronts.emplace_back(s->x + dx, s->y + dy);
+            } else if (s->alive && s->type == RobotType::Worker) {
+                in.workers.push_back({ s->x, s->y, s->dir, s->carrying,
+                                       s->carrying && s->boxId ? *s->boxId : -1 });
+            }
+        }
+    };
+    collect(level.getRobots());
+    collect(level.getPlacedRobots());
+
+    return hopelessFor(level, in, shift);
+}
+
+bool GameEngine::hopelessFor(const Level& lvl, const HopelessInput& in, int shift) {
+    // шлях без поворотів: клітинки (x + i*dx, y + i*dy), 0 <= i <= reach
+    struct Ray { int x, y, dx, dy, reach; };
+    auto rayFrom = [&](int x, int y, Direction d) {
+        auto [dx, dy] = dirDelta(d);
+        return Ray{ x, y, dx, dy, lvl.isInside(x, y) ? lvl.rayDistance(x, y, d) : 0 };
+    };
+    // номер кроку клітинки на промені або -1
+    auto stepOn = [](const Ray& r, int x, int y) {
+        int ox = x - r.x, oy = y - r.y;
+        int steps = r.dx ? ox * r.dx : oy * r.dy;
+        bool onRay = (r.dx ? oy == 0 : ox == 0) && steps >= 0 && steps <= r.reach;
+        return onRay ? steps : -1;
+    };
+
+    const auto& workers = in.workers;
+    const auto& fronts = in.fronts;
+    std::vector<Ray> rays;                     // перші workers.size() — промені робітників
+
+    // без живих робітників поразку фіксує isLose
+    if (workers.empty()) return false;
+
+    // Робітник їде прямо, доки контролер не поверне його. Тому досяжні
+    // лише промені робітників і промені в усі боки з клітинок перед
+    // контролерами, до яких якийсь промінь доходить.
+    const bool straight = in.rotationsOnly && !in.manualCommands;
+
+    if (!straight) {
+        for (auto& b : *in.boxes) {
+            if (b.delivered) continue;
+            if (lvl.targetDistance(b.x, b.y) < 0) return true;
+
+            bool reachable = false;
+            for (auto& s : workers) {
+                // робітник у стіні (ще не розставлений) може вийти куди завгодно
+                int c = lvl.componentAt(s.x, s.y);
+                if (c < 0 || c == lvl.componentAt(b.x, b.y)) { reachable = true; break; }
+            }
+            if (!reachable) return true;
+        }
+        return false;
+    }
+
+    for (auto& s : workers) {
+        auto [dx, dy] = dirDelta(s.dir);
+        rays.push_back(rayFrom(s.x + shift * dx, s.y + shift * dy, s.dir));
+    }
+
+    std::vector<size_t> frontRays(fronts.size(), 0);   // перший з 4 променів клітинки
+    for (size_t i = 0; i < rays.size(); ++i) {
+        for (size_t f = 0; f < fronts.size(); ++f) {
+            if (frontRays[f] || stepOn(rays[i], fronts[f].first, fronts[f].second) < 0) continue;
+            frontRays[f] = rays.size();
+            for (Direction d : { Direction::Up, Direction::Down, Direction::Left, Direction::Right })
+                rays.push_back(rayFrom(fronts[f].first, fronts[f].second, d));
+        }
+    }
+
+    // перший крок на r, не раніше lo, що лежить на o від кроку from; -1 — немає
+    auto meet = [](const Ray& r, int lo, const Ray& o, int from) {
+        if (from > o.reach) return -1;
+        auto along  = [&](int x, int y) { return (x - r.x) * r.dx + (y - r.y) * r.dy; };
+        auto across = [&](int x, int y) { return (x - r.x) * r.dy - (y - r.y) * r.dx; };
+
+        int x0 = o.x + from * o.dx, y0 = o.y + from * o.dy;
+        int x1 = o.x + o.reach * o.dx, y1 = o.y + o.reach * o.dy;
+        int c0 = across(x0, y0), c1 = across(x1, y1);
+        if (std::min(c0, c1) > 0 || std::max(c0, c1) < 0) return -1;
+
+        int a0 = along(x0, y0), a1 = along(x1, y1);
+        int step = std::max(std::min(a0, a1), lo);
+        return step <= std::min(std::max(a0, a1), r.reach) ? step : -1;
+    };
+
+    // з вантажем робітник підбере іншу коробку лише за першою ціллю
+    std::vector<int> pickFrom(rays.size(), 1);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        if (!workers[i].carrying) continue;
+        pickFrom[i] = INT_MAX;
+        for (auto& t : lvl.getTargets()) {
+            int step = stepOn(rays[i], t.first, t.second);
+            if (step > 0) pickFrom[i] = std::min(pickFrom[i], step + 1);
+        }
+    }
+
+    // Коробку везуть променем від кроку at[i]; загинувши деінде, носій
+    // лишає її там, і її може підібрати інший промінь, що туди заходить.
+    std::vector<int> at(rays.size());
+    for (auto& b : *in.boxes) {
+        if (b.delivered) continue;
+
+        // від коробки стінами відрізані всі цілі
+        if (lvl.targetDistance(b.x, b.y) < 0) return true;
+
+        size_t carrier = rays.size();
+        for (size_t i = 0; i < workers.size(); ++i)
+            if (workers[i].carrying && workers[i].boxId == b.id) { carrier = i; break; }
+
+        // вантаж їде з носієм; решту підбирають, лише заходячи в клітинку
+        const Ray spot{ b.x, b.y, 0, 0, 0 };
+        for (size_t i = 0; i < rays.size(); ++i) {
+            int step = carrier < rays.size() ? (i == carrier ? 0 : -1)
+                                             : meet(rays[i], pickFrom[i], spot, 0);
+            at[i] = step < 0 ? INT_MAX : step;
+        }
+
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (size_t i = 0; i < rays.size(); ++i) {
+                if (at[i] == INT_MAX) continue;
+
+                for (size_t j = 0; j < rays.size(); ++j) {
+                    int step = meet(rays[j], pickFrom[j], rays[i], at[i]);
+                    if (step >= 0 && step < at[j]) { at[j] = step; changed = true; }
+                }
+                for (size_t f = 0; f < fronts.size(); ++f) {
+                    if (!frontRays[f] || stepOn(rays[i], fronts[f].first, fronts[f].second) < at[i]) continue;
+                    for (size_t k = frontRays[f]; k < frontRays[f] + 4; ++k)
+                        if (at[k] > 0) { at[k] = 0; changed = true; }
+                }
+            }
+        }
+
+        bool deliverable = false;
+        for (size_t i = 0; i < rays.size() && !deliverable; ++i) {
+            if (at[i] == INT_MAX) continue;
+            for (auto& t : lvl.getTargets())
+                if (stepOn(rays[i], t.first, t.second) >= std::max(at[i], 1)) { deliverable = true; break; }
+        }
+        if (!deliverable) return true;
+    }
+    return false;
+}
+
@@ -1,7 +1,12 @@
 #pragma once
 #include "Level.hpp"
 #include "Types.hpp"
+#include "History.hpp"
+#include "RunTrace.hpp"
+#include "StateSet.hpp"
 #include <nlohmann/json.hpp>
+#include <memory>
+#include <optional>
 
 class GameEngine {
 public:
@@ -10,6 +15,72 @@ public:
     bool isWin() const;
     bool isLose() const;
 
+    // Перемога вже неможлива, хоч живі робітники ще є: якась коробка не
+    // дістанеться цілі. Рахується після кожного ходу, isLose це враховує.
+    bool isHopeless() const { return hopeless_; }
+    void setEarlyLose(bool on) { earlyLose_ = on; hopeless_ = computeHopeless(); }
+    bool earlyLose() const { return earlyLose_; }
+    bool hadManualCommands() const { return manualCommands_; }
+
+    // Плоский опис стану для оцінки безнадійності: його збирає і цей
+    // рушій зі своїх роботів, і BitboardEngine зі своїх масивів
+    struct HopelessInput {
+        struct Worker { int x, y; Direction dir; bool carrying; int boxId; };
+        std::vector<Worker> workers;                  // лише живі
+        std::vector<std::pair<int,int>> fronts;       // клітинки перед контролерами з командою
+        bool rotationsOnly = true;                    // у командах контролерів лише повороти
+        bool manualCommands = false;
+        const std::vector<Box>* boxes = nullptr;
+    };
+    static bool hopelessFor(const Level& lvl, const HopelessInput& in, int shift = 0);
+
+    // стан світу повторився під час автоматичного прогону — гра не завершиться
+    bool isNonTerminating() const { return nonTerminating_; }
+    bool isFinished() const { return isWin() || isLose() || nonTerminating_; }
+
+    struct RunResult {
+        int ticks = 0;
+        bool win = false;
+        bool lose = false;
+        bool nonTerminating = false;
+        int resumedFrom = 0;   // хід знімка, з якого продовжено прогін
+    };
+    RunResult runUntilFinished(int maxTicks);
+
+    // Кількість найближчих ходів (до limit), у яких гарантовано нічого не
+    // станеться: робітники лише зсуваються на клітинку вперед.
+    int quietTicks(int limit) const;
+
+    // Один хід або стрибок через тихі ходи одразу; повертає кількість ходів.
+    int advance(int maxTicks);
+    void setFastForward(bool on) { fastForward_ = on; }
+    bool fastForward() const { return fastForward_; }
+
+    // Карти до 256 клітинок ганяються на бітбордах (BitboardEngine), якщо
+    // прогін не веде історії й знімків. Розмір вибирається в loadLevel;
+    // 0 — карта завелика або бітборди вимкнено.
+    void setBitboard(bool on) { bitboard_ = on; }
+    bool bitboard() const { return bitboard_; }
+    int bitboardWords() const { return bitboard_ ? bitboardWords_ : 0; }
+
+    // Зміна розстановки робота id до старту. Якщо останній прогін ще
+    // збережений, run_until_finished продовжить його з найпізнішого знімка,
+    // до якого правка ні на що не вплинула.
+    bool editPlacement(int id, int x, int y, Direction dir,
+                       std::optional<CommandType> command = std::nullopt);
+    void setCheckpointInterval(int ticks) { trace_.setInterval(ticks); }
+    int checkpointInterval() const { return trace_.interval(); }
+    const RunTrace& getTrace() const { return trace_; }
+
+    // 64-бітний Zobrist-хеш динамічного стану (роботи, коробки)
+    uint64_t getStateHash() const { return hash_; }
+    uint64_t computeStateHash() const;
+    void rehash();
+
+    // ключі Zobrist одного робота (pending — команда контролера) і коробки
+    static uint64_t robotKeyOf(const RobotState& s, const Command* pending);
+    static uint64_t boxKeyOf(const Box& b);
+
     bool locked_ = false;
     //bool isLocked() const { return locked_; }
     void lock() { locked_ = true; }
@@ -17,6 +88,40 @@ public:
     void stepAuto();
     void loadLevel(Level&& lvl);
 
+    // повернення до стану одразу після load_level / до першого run_step
+    void reset();
+    void resetKeepPlacements();
+    bool isRunning() const { return running_; }
+
+    // форк світу для пошуку: рельєф спільний, копіюється динамічний шар.
+    // Історія undo, слід прогону й буфери запису ходу не копіюються.
+    // seen_ (хеші станів поточного прогону) — плоский масив, копія одним
+    // memcpy: форк посеред прогону має помітити цикл на тому ж ході, що й
+    // оригінал. Роботи копіюються глибоко через Robot::clone: це поліморфні
+    // об'єкти з покажчиками на свій RobotState, які в копії мусять вказувати
+    // на її власні стани, — тож плоского масиву для них немає.
+    // oop_bench міряє форк до першого ходу і посеред прогону
+    GameEngine clone() const { return *this; }
+
+    LevelSnapshot saveState() const { return level.snapshot(); }
+    void restoreState(const LevelSnapshot& snap, bool running,
+                      const LevelSnapshot* started = nullptr);
+    const LevelSnapshot* getStartedSnapshot() const { return started_.get(); }
+
+    // Стан прогону поза знімком рівня — для keyframe-ів журналу відтворення.
+    // seenEpoch() росте з кожним очищенням seen_, тож за ним видно, чи
+    // множина лише доповнилась від попереднього читання.
+    const StateSet& seenStates() const { return seen_; }
+    uint64_t seenEpoch() const { return seenEpoch_; }
+    // після restoreState: ручні команди, виявлений цикл і бачені стани
+    void restoreRun(bool manualCommands, bool nonTerminating, const std::vector<uint64_t>& seen);
+
+    // скасування останніх n ходів; повертає, скільки скасовано
+    size_t undo(size_t n = 1);
+    void setHistoryDepth(size_t depth) { history_.setDepth(depth); }
+    size_t historyDepth() const { return history_.depth(); }
+    size_t historySize() const { return history_.size(); }
+
     void spawnPlacedRobot(int x, int y, const std::string& type);
     void commitPlacedRobots();
 
@@ -30,16 +135,73 @@ public:
     void applyCommands(const std::vector<Command>& cmds);
     void update();
 
+    static bool bfs_reachable(const Level& lvl,
+                              int sx, int sy,
+                              const std::pair<int,int>& target);
+
     const Level& getLevel() const { return level; }
     Level& getLevelMutable() { return level; }
 
 private:
     Level level;
+    bool running_ = false;
+
+    std::shared_ptr<const LevelSnapshot> pristine_;
+    std::shared_ptr<const LevelSnapshot> started_;
+
+    History history_;
+
+    // Запис поточного ходу: перед першою зміною робота чи коробки за хід
+    // у delta іде її попереднє значення; позначки з номером запису
+    // не дають записати те саме двічі. Це робочі буфери, тож форк
+    // отримує їх порожніми
+    struct DeltaScratch {
+        TickDelta delta;
+        bool recording = false;
+        uint32_t mark = 0;
+        std::vector<uint32_t> robotMarks, boxMarks;
+
+        DeltaScratch() = default;
+        DeltaScratch(const DeltaScratch&) {}
+        DeltaScratch& operator=(const DeltaScratch&) { return *this = DeltaScratch(); }
+        DeltaScratch(DeltaScratch&&) = default;
+        DeltaScratch& operator=(DeltaScratch&&) = default;
+    };
+    DeltaScratch scratch_;
+    void beginDelta(bool wasRunning);
+    void noteRobot(const RobotState* s);
+    void noteRobotId(int id);
+    void noteBox(int boxId);
+    void noteCommand(bool placed, size_t position, const Command& before);
+    void sweepDead(std::vector<std::unique_ptr<Robot>>& list, bool placed);
+    void endDelta();
+
+    uint64_t hash_ = 0;
+    bool nonTerminating_ = false;
+    StateSet seen_;
+    uint64_t seenEpoch_ = 0;
+    void forgetSeen();
+
+    bool fastForward_ = true;
+    void jump(int ticks);
+
+    bool bitboard_ = true;
+    int bitboardWords_ = 0;
+    int runBitboard(int maxTicks);
+
+    bool earlyLose_ = true;
+    bool hopeless_ = false;
+    bool manualCommands_ = false;   // ручні команди можуть повернути робітника будь-куди
+    bool computeHopeless(int shift = 0) const;
+
+    RunTrace trace_;
+    int resumeFromTrace();
+
+    uint64_t robotKey(const Robot& r) const;
+    uint64_t boxKey(int boxId) const;
+    void updateLevel();
 
     Robot* findRobotById(int id);
     std::vector<Command> collectControllerCommands();  
 
-    static bool bfs_reachable(const Level& lvl,
-                              int sx, int sy,
-                              const std::pair<int,int>& target);
 };
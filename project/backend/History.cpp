@@ -0,0 +1,48 @@
+#include "History.hpp"
+#include <utility>
+
+History::History(size_t depth) : depth_(depth) {}
+
+History& History::operator=(const History& other) {
+    if (this != &other) {
+        depth_ = other.depth_;
+        ring_.clear();
+        head_ = 0;
+        count_ = 0;
+    }
+    return *this;
+}
+
+void History::setDepth(size_t depth) {
+    depth_ = depth;
+    ring_.clear();
+    head_ = 0;
+    count_ = 0;
+}
+
+void History::push(TickDelta& d) {
+    if (depth_ == 0) return;
+    if (ring_.size() != depth_) ring_.resize(depth_);
+
+    std::swap(ring_[head_], d);
+    head_ = (head_ + 1) % ring_.size();
+    if (count_ < ring_.size()) ++count_;
+}
+
+bool History::pop(TickDelta& out) {
+    if (count_ == 0) return false;
+
+    head_ = (head_ + ring_.size() - 1) % ring_.size();
+    out = std::move(ring_[head_]);
+    ring_[head_] = TickDelta{};
+    --count_;
+    return true;
+}
+
+// кільце лишається виділеним: після reset записи підуть у нього ж
+void History::clear() {
+    for (size_t i = 0; i < count_; ++i)
+        ring_[(head_ + ring_.size() - 1 - i) % ring_.size()] = TickDelta{};
+    head_ = 0;
+    count_ = 0;
+}
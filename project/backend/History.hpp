@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Types.hpp"
+
+// Зміни одного ходу: попередні значення лише тих роботів і коробок,
+// які змінилися (рух, смерть, підбір, доставка, поворот), забрані команди
+// контролерів і прибрані зі списків мертві роботи. Рушій пише їх у точках
+// зміни, а Level::revert відкочує на місці, без знімків рівня.
+struct TickDelta {
+    struct RobotChange { uint32_t index; RobotState before; };   // index — у robotStates
+    struct BoxChange   { uint32_t index; Box before; };
+    // position — у списку robots або placedRobots на момент зміни
+    struct CommandChange { bool placed; uint32_t position; Command before; };
+    struct Removal {
+        bool placed;
+        uint32_t position;
+        uint32_t index;
+        bool hasCommand = false;
+        Command command{};
+    };
+
+    int movesBefore = 0;
+    bool wasRunning = false;
+    std::vector<RobotChange> robots;
+    std::vector<BoxChange> boxes;
+    std::vector<CommandChange> commands;
+    std::vector<Removal> removed;   // у порядку прибирання
+};
+
+// Кільцевий буфер останніх ходів обмеженої глибини.
+// Копія (форк рушія) переймає лише глибину, але не самі записи.
+class History {
+public:
+    explicit History(size_t depth = 256);
+    History(const History& other) : depth_(other.depth_) {}
+    History& operator=(const History& other);
+    History(History&&) = default;
+    History& operator=(History&&) = default;
+
+    void setDepth(size_t depth);
+    size_t depth() const { return depth_; }
+    size_t size() const { return count_; }
+
+    // d іде в кільце, натомість у d — витіснений запис: його вектори
+    // з уже виділеною пам'яттю годяться для наступного ходу
+    void push(TickDelta& d);
+    bool pop(TickDelta& out);
+    void clear();
+
+private:
+    size_t depth_;
+    std::vector<TickDelta> ring_;   // виділяється при першому записі
+    size_t head_ = 0;    // наступна позиція запису
+    size_t count_ = 0;
+};
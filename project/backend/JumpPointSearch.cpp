@@ -0,0 +1,210 @@
+#include "JumpPointSearch.hpp"
+#include "Bits.hpp"
+
+#include <cstdlib>
+#include <queue>
+#include <unordered_map>
+
+// Розкладка та сама — лише доставити нові стіни; інакше рядки з нуля
+void JumpPointSearch::sync(const Level& lvl) {
+    auto& walls = lvl.getWalls();
+
+    if (lvl.layoutId() != layout_ || lvl.getWidth() != width_ || lvl.getHeight() != height_ ||
+        walls.size() < wallsSeen_)
+    {
+        layout_ = lvl.layoutId();
+        width_ = lvl.getWidth();
+        height_ = lvl.getHeight();
+        words_ = (width_ + 63) / 64;
+        wallsSeen_ = walls.size();
+
+        // біти за правим краєм лишаються нулями — як стіна
+        free_.assign((size_t)words_ * height_, 0);
+        for (int y = 0; y < height_; ++y)
+            for (int x = 0; x < width_; ++x)
+                if (!lvl.isWall(x, y))
+                    free_[(size_t)y * words_ + (x >> 6)] |= 1ull << (x & 63);
+        return;
+    }
+
+    for (; wallsSeen_ < walls.size(); ++wallsSeen_) {
+        int x = walls[wallsSeen_].first, y = walls[wallsSeen_].second;
+        if (x < 0 || y < 0 || x >= width_ || y >= height_) continue;
+        free_[(size_t)y * words_ + (x >> 6)] &= ~(1ull << (x & 63));
+    }
+}
+
+bool JumpPointSearch::isFree(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width_ || y >= height_) return false;
+    return (free_[(size_t)y * words_ + (x >> 6)] >> (x & 63)) & 1;
+}
+
+// Подія — стіна в рядку y або клітинка, над/під якою вертикаль вільна,
+// а позаду (з боку, звідки йдемо) — ні. Перша подія за x вирішує все.
+int JumpPointSearch::scanRow(int x, int y, int dx) const {
+    const uint64_t* cur = &free_[(size_t)y * words_];
+    const uint64_t* up = y > 0 ? cur - words_ : nullptr;
+    const uint64_t* down = y + 1 < height_ ? cur + words_ : nullptr;
+    const bool goalRow = y == goalY_;
+
+    if (dx > 0) {
+        int from = x + 1;
+        for (int w = from >> 6; w < words_; ++w) {
+            uint64_t ev = ~cur[w];
+            // біт x отримує сусіда x - 1
+            if (up) ev |= up[w] & ~((up[w] << 1) | (w > 0 ? up[w - 1] >> 63 : 0));
+            if (down) ev |= down[w] & ~((down[w] << 1) | (w > 0 ? down[w - 1] >> 63 : 0));
+            if (goalRow && (goalX_ >> 6) == w) ev |= 1ull << (goalX_ & 63);
+            if (w == from >> 6) ev &= ~0ull << (from & 63);
+            if (ev) {
+                int b = w * 64 + ctz64(ev);
+                return isFree(b, y) ? b : -1;
+            }
+        }
+        return -1;
+    }
+
+    int from = x - 1;
+    if (from < 0) return -1;
+    for (int w = from >> 6; w >= 0; --w) {
+        uint64_t ev = ~cur[w];
+        // біт x отримує сусіда x + 1
+        if (up) ev |= up[w] & ~((up[w] >> 1) | (w + 1 < words_ ? up[w + 1] << 63 : 0));
+        if (down) ev |= down[w] & ~((down[w] >> 1) | (w + 1 < words_ ? down[w + 1] << 63 : 0));
+        if (goalRow && (goalX_ >> 6) == w) ev |= 1ull << (goalX_ & 63);
+        if (w == from >> 6) ev &= ~0ull >> (63 - (from & 63));
+        if (ev) {
+            int b = w * 64 + msb64(ev);
+            return isFree(b, y) ? b : -1;
+        }
+    }
+    return -1;
+}
+
+int JumpPointSearch::scanColumn(int x, int y, int dy) const {
+    for (y += dy; isFree(x, y); y += dy) {
+        if (x == goalX_ && y == goalY_) return y;
+        if (scanRow(x, y, 1) >= 0 || scanRow(x, y, -1) >= 0) return y;
+    }
+    return -1;
+}
+
+// Канонічні шляхи: з вертикалі можна звернути будь-де (горизонтальні
+// стрибки з кожної її клітинки), з горизонталі на вертикаль — лише там,
+// де клітинка позаду по діагоналі зайнята; інакше той самий шлях можна
+// звернути на крок раніше. Вузол — клітинка разом з напрямком входу.
+std::vector<std::pair<int,int>> JumpPointSearch::search(int sx, int sy, int tx, int ty) {
+    goalX_ = tx;
+    goalY_ = ty;
+    expanded_ = 0;
+
+    enum { Up, Down, Left, Right, Start };
+    const int dx[4] = { 0, 0, -1, 1 };
+    const int dy[4] = { -1, 1, 0, 0 };
+
+    struct Node { int g; int64_t parent; bool closed; };
+    struct Open { int f, g; int64_t key; };
+    auto worse = [](const Open& a, const Open& b) {
+        return a.f != b.f ? a.f > b.f : a.g < b.g;
+    };
+
+    auto keyOf = [&](int x, int y, int d) { return ((int64_t)y * width_ + x) * 5 + d; };
+
+    std::unordered_map<int64_t, Node> nodes;
+    std::priority_queue<Open, std::vector<Open>, decltype(worse)> open(worse);
+
+    auto h = [&](int x, int y) { return std::abs(x - tx) + std::abs(y - ty); };
+
+    const int64_t startKey = keyOf(sx, sy, Start);
+    nodes[startKey] = { 0, -1, false };
+    open.push({ h(sx, sy), 0, startKey });
+
+    while (!open.empty()) {
+        Open cur = open.top();
+        open.pop();
+        Node& node = nodes[cur.key];
+        if (node.closed || node.g < cur.g) continue;
+        node.closed = true;
+        ++expanded_;
+
+        const int cell = (int)(cur.key / 5);
+        const int from = (int)(cur.key % 5);
+        const int x = cell % width_, y = cell / width_;
+
+        if (x == tx && y == ty) {
+            std::vector<std::pair<int,int>> points;
+            for (int64_t k = cur.key; k >= 0; k = nodes[k].parent) {
+                int c = (int)(k / 5);
+                points.emplace_back(c % width_, c / width_);
+            }
+            return { points.rbegin(), points.rend() };
+        }
+
+        bool dirs[4] = { false, false, false, false };
+        if (from == Start) {
+            dirs[Up] = dirs[Down] = dirs[Left] = dirs[Right] = true;
+        } else if (from == Up || from == Down) {
+            dirs[from] = dirs[Left] = dirs[Right] = true;
+        } else {
+            dirs[from] = true;
+            const int back = x - dx[from];
+            for (int v : { Up, Down })
+                if (isFree(x, y + dy[v]) && !isFree(back, y + dy[v])) dirs[v] = true;
+        }
+
+        for (int d = 0; d < 4; ++d) {
+            if (!dirs[d]) continue;
+
+            int nx = x, ny = y;
+            if (dx[d] != 0) {
+                nx = scanRow(x, y, dx[d]);
+                if (nx < 0) continue;
+            } else {
+                ny = scanColumn(x, y, dy[d]);
+                if (ny < 0) continue;
+            }
+
+            const int g = cur.g + std::abs(nx - x) + std::abs(ny - y);
+            const int64_t key = keyOf(nx, ny, d);
+            auto it = nodes.find(key);
+            if (it != nodes.end() && it->second.g <= g) continue;
+            nodes[key] = { g, cur.key, false };
+            open.push({ g + h(nx, ny), g, key });
+        }
+    }
+    return {};
+}
+
+int JumpPointSearch::distance(const Level& lvl, int sx, int sy, int tx, int ty) {
+    auto cells = path(lvl, sx, sy, tx, ty);
+    return (int)cells.size() - 1;
+}
+
+std::vector<std::pair<int,int>> JumpPointSearch::path(const Level& lvl, int sx, int sy, int tx, int ty) {
+    std::vector<std::pair<int,int>> cells;
+    if (!lvl.isInside(sx, sy) || !lvl.isInside(tx, ty) || lvl.isWall(sx, sy) || lvl.isWall(tx, ty))
+        return cells;
+    // різні компоненти — A* обійшов би всю карту, щоб це з'ясувати
+    if (lvl.componentAt(sx, sy) != lvl.componentAt(tx, ty))
+        return cells;
+
+    sync(lvl);
+    auto points = search(sx, sy, tx, ty);
+
+    // точки стрибків з'єднані прямими відрізками
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (i == 0) {
+            cells.push_back(points[0]);
+            continue;
+        }
+        int x = points[i - 1].first, y = points[i - 1].second;
+        const int stepX = (points[i].first > x) - (points[i].first < x);
+        const int stepY = (points[i].second > y) - (points[i].second < y);
+        while (x != points[i].first || y != points[i].second) {
+            x += stepX;
+            y += stepY;
+            cells.emplace_back(x, y);
+        }
+    }
+    return cells;
+}
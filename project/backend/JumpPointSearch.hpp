@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Level.hpp"
+
+// Jump point search для 4-зв'язної сітки (варіант JPS4): з усіх найкоротших
+// шляхів розглядаються лише ті, що звертають з горизонталі на вертикаль
+// тільки біля кута стіни. Тому A* відкриває лише точки стрибків, а прямі
+// відрізки між ними проглядаються по бітових рядках вільних клітинок —
+// по 64 клітинки за раз. Пам'ять — W*H біт, без полів на всю карту.
+// Не потокобезпечний: бітові рядки оновлюються під час запиту.
+class JumpPointSearch {
+public:
+    // довжина найкоротшого шляху; -1 — недосяжно або клітинка поза картою/у стіні
+    int distance(const Level& lvl, int sx, int sy, int tx, int ty);
+
+    // клітинки шляху від (sx, sy) до (tx, ty) включно; порожній — недосяжно
+    std::vector<std::pair<int,int>> path(const Level& lvl, int sx, int sy, int tx, int ty);
+
+    // скільки точок стрибків відкрив останній запит
+    size_t lastExpanded() const { return expanded_; }
+
+private:
+    uint64_t layout_ = 0;
+    size_t wallsSeen_ = 0;
+    int width_ = 0, height_ = 0;
+    int words_ = 0;                   // слів на рядок
+    std::vector<uint64_t> free_;      // рядок y: free_[y*words_ ...], біт x — клітинка вільна
+
+    int goalX_ = 0, goalY_ = 0;
+    size_t expanded_ = 0;
+
+    void sync(const Level& lvl);
+    bool isFree(int x, int y) const;
+
+    // найближча точка стрибка праворуч (dx = 1) чи ліворуч (dx = -1) від x
+    // у рядку y: ціль або клітинка, з якої вертикаль відкривається за кутом
+    // стіни; -1 — раніше стіна або край
+    int scanRow(int x, int y, int dx) const;
+    // вертикальний стрибок: зупинка на цілі або там, де горизонтальний
+    // стрибок щось знаходить; -1 — стіна або край
+    int scanColumn(int x, int y, int dy) const;
+
+    // A* по точках стрибків; повертає вузли шляху від старту до цілі
+    std::vector<std::pair<int,int>> search(int sx, int sy, int tx, int ty);
+};
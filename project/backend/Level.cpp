@@ -3,12 +3,200 @@
 #include "Types.hpp"
 
 #include "GameEngine.hpp"
+#include "History.hpp"
+#include "Bits.hpp"
+#include "WorkerRobot.hpp"
+#include "ControllerRobot.hpp"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <queue>
+
+static uint64_t nextLayoutId() {
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
 Level::Level(int w, int h)
     : width(w), height(h),
-      grid(h, std::vector<char>(w, '.')),
-      gridCells(h, std::vector<Cell>(w)) 
+      terrain(std::make_shared<Terrain>())
+{
+    terrain->grid.assign(h, std::vector<char>(w, '.'));
+    terrain->gridCells.assign(h, std::vector<Cell>(w));
+    terrain->flags.assign((size_t)w * h, 0);
+    terrain->layout = nextLayoutId();
+    rebuildRays();
+    rebuildRegions();
+}
+
+Level::Level(const Level& other)
+    : width(other.width), height(other.height),
+      moves(other.moves),
+      terrain(other.terrain),
+      boxStates(other.boxStates)
 {
+    robotStates.reserve(other.robotStates.size());
+    for (auto& st : other.robotStates)
+        robotStates.push_back(std::make_unique<RobotState>(*st));
+
+    auto cloneList = [&](const std::vector<std::unique_ptr<Robot>>& src,
+                         std::vector<std::unique_ptr<Robot>>& dst) {
+        dst.reserve(src.size());
+        for (auto& r : src) {
+            auto c = r->clone();
+            size_t idx = other.stateIndex(r->getState());
+            c->attachState(idx < robotStates.size() ? robotStates[idx].get() : nullptr);
+            dst.push_back(std::move(c));
+        }
+    };
+
+    cloneList(other.robots, robots);
+    cloneList(other.placedRobots, placedRobots);
+}
+
+Level& Level::operator=(const Level& other) {
+    if (this != &other) *this = Level(other);
+    return *this;
+}
+
+// копія рельєфу отримує нову мітку: інакше дві копії з різними новими
+// стінами мали б однаковий ключ (layoutId, кількість стін) у кешах
+Level::Terrain& Level::mutableTerrain() {
+    if (terrain.use_count() > 1) {
+        terrain = std::make_shared<Terrain>(*terrain);
+        terrain->layout = nextLayoutId();
+    }
+    return *terrain;
+}
+
+// індекс стану в robotStates; зазвичай id - 1
+size_t Level::stateIndex(const RobotState* s) const {
+    if (!s) return robotStates.size();
+
+    size_t idx = (size_t)(s->id - 1);
+    if (idx < robotStates.size() && robotStates[idx].get() == s)
+        return idx;
+
+    for (idx = 0; idx < robotStates.size(); ++idx)
+        if (robotStates[idx].get() == s) break;
+    return idx;
+}
+
+size_t Level::memoryFootprint() const {
+    size_t bytes = sizeof(Level);
+    bytes += (size_t)height * (width * (2 * sizeof(char) + sizeof(Cell)) + 2 * sizeof(std::vector<char>));
+    bytes += terrain->rays.size() * sizeof(uint16_t);
+    bytes += (terrain->component.size() + terrain->targetDist.size()) * sizeof(int32_t);
+    bytes += (terrain->walls.size() + terrain->targets.size() + terrain->boxesPos.size()) * sizeof(std::pair<int,int>);
+    bytes += boxStates.size() * sizeof(Box);
+    bytes += robotStates.size() * (sizeof(RobotState) + sizeof(void*));
+    bytes += (robots.size() + placedRobots.size()) * (sizeof(void*) + 64);
+    return bytes;
+}
+
+LevelSnapshot Level::snapshot() const {
+    LevelSnapshot snap;
+    snap.moves = moves;
+    snap.boxes = boxStates;
+    snap.robots.reserve(robotStates.size());
+
+    for (auto& st : robotStates) {
+        RobotSnapshot rs;
+        rs.state = *st;
+        rs.listed = false;
+        snap.robots.push_back(rs);
+    }
+
+    // роботи у списках ідуть у порядку додавання, тож достатньо позначок
+    auto mark = [&](const std::vector<std::unique_ptr<Robot>>& arr, bool placed) {
+        for (auto& r : arr) {
+            auto* s = r->getState();
+            if (!s) continue;
+
+            size_t idx = stateIndex(s);
+            if (idx == robotStates.size()) continue;
+
+            RobotSnapshot& rs = snap.robots[idx];
+            rs.listed = true;
+            rs.placed = placed;
+
+            if (auto* c = dynamic_cast<const ControllerRobot*>(r.get())) {
+                if (c->hasPendingCommand()) {
+                    rs.hasCommand = true;
+                    rs.command = *c->getPendingCommand();
+                }
+            }
+        }
+    };
+    mark(robots, false);
+    mark(placedRobots, true);
+
+    return snap;
+}
+
+void Level::restore(const LevelSnapshot& snap) {
+    moves = snap.moves;
+    boxStates = snap.boxes;
+
+    robots.clear();
+    placedRobots.clear();
+    robotStates.resize(snap.robots.size());
+
+    for (size_t i = 0; i < snap.robots.size(); ++i) {
+        const RobotSnapshot& rs = snap.robots[i];
+
+        if (!robotStates[i]) robotStates[i] = std::make_unique<RobotState>();
+        *robotStates[i] = rs.state;
+
+        if (rs.listed)
+            (rs.placed ? placedRobots : robots).push_back(makeListed(i, rs.hasCommand, rs.command));
+    }
+}
+
+// об'єкт робота для стану robotStates[index], як його створює restore
+std::unique_ptr<Robot> Level::makeListed(size_t index, bool hasCommand, const Command& command) {
+    const RobotState& s = *robotStates[index];
+
+    std::unique_ptr<Robot> r;
+    if (s.type == RobotType::Worker) {
+        r = std::make_unique<WorkerRobot>();
+    } else {
+        auto c = std::make_unique<ControllerRobot>();
+        if (hasCommand) c->setCommand(command);
+        r = std::move(c);
+    }
+
+    r->setPosition(s.x, s.y);
+    r->setDirection(s.dir);
+    r->attachState(robotStates[index].get());
+    return r;
+}
+
+void Level::revert(const TickDelta& d) {
+    moves = d.movesBefore;
+
+    for (auto& c : d.robots)
+        if (c.index < robotStates.size()) *robotStates[c.index] = c.before;
+    for (auto& c : d.boxes)
+        if (c.index < boxStates.size()) boxStates[c.index] = c.before;
+
+    // прибрані роботи повертаються у зворотному порядку, тож кожна позиція
+    // знову відповідає списку на момент прибирання
+    for (auto it = d.removed.rbegin(); it != d.removed.rend(); ++it) {
+        if (it->index >= robotStates.size()) continue;
+        auto& list = it->placed ? placedRobots : robots;
+        size_t pos = std::min<size_t>(it->position, list.size());
+        list.insert(list.begin() + pos, makeListed(it->index, it->hasCommand, it->command));
+    }
+
+    for (auto& c : d.commands) {
+        auto& list = c.placed ? placedRobots : robots;
+        if (c.position >= list.size()) continue;
+        if (auto* ctl = dynamic_cast<ControllerRobot*>(list[c.position].get()))
+            ctl->setCommand(c.before);
+    }
 }
 
 void Level::addRobot(std::unique_ptr<Robot> r) {
@@ -27,9 +215,6 @@ void Level::addRobot(std::unique_ptr<Robot> r) {
 
     r->attachState(stptr);
     robots.push_back(std::move(r));
-
-    rebuildBackground();
-    rebuildCells();
 }
 
 void Level::addPlacedRobot(std::unique_ptr<Robot> r) {
@@ -48,9 +233,6 @@ void Level::addPlacedRobot(std::unique_ptr<Robot> r) {
 
     r->attachState(stptr);
     placedRobots.push_back(std::move(r));
-
-    rebuildBackground();
-    rebuildCells();
 }
 
 void Level::clearPlacedRobots() {
@@ -71,28 +253,48 @@ void Level::clearPlacedRobots() {
     }
 
     placedRobots.clear();
-
-    rebuildBackground();
-    rebuildCells();
 }
 
+// нова стіна змінює лише свій рядок і стовпець і свою область —
+// сітку не перебудовуємо
 void Level::addWall(int x, int y) {
     if (!isInside(x,y)) return;
-    walls.emplace_back(x,y);
-    rebuildBackground();
-    rebuildCells();
+
+    if (isWall(x,y)) return;
+
+    Terrain& t = mutableTerrain();
+    t.walls.emplace_back(x,y);
+
+    uint8_t& f = t.flags[(size_t)y * width + x];
+    f |= FlagWall;
+
+    if (!(f & (FlagTarget | FlagBox))) t.grid[y][x] = 'X';
+    if (!(f & FlagTarget)) t.gridCells[y][x].type = CellType::Wall;
+
+    updateRaysAround(x, y);
+    updateRegionsAroundWall(x, y);
 }
 
 void Level::addTarget(int x, int y) {
     if (!isInside(x,y)) return;
-    targets.emplace_back(x,y);
-    rebuildBackground();
-    rebuildCells();
+
+    Terrain& t = mutableTerrain();
+    t.targets.emplace_back(x,y);
+    t.layout = nextLayoutId();
+
+    // як у rebuildBackground/rebuildCells: ціль поверх стіни, коробка поверх цілі
+    uint8_t& f = t.flags[(size_t)y * width + x];
+    f |= FlagTarget;
+    if (!(f & FlagBox)) t.grid[y][x] = 'T';
+    t.gridCells[y][x].type = CellType::Target;
+
+    updateRegionsAroundTarget(x, y);
 }
 
 void Level::addBox(int x, int y) {
     if (!isInside(x,y)) return;
-    boxesPos.emplace_back(x,y);
+    mutableTerrain().boxesPos.emplace_back(x,y);
+    terrain->layout = nextLayoutId();
 
     boxStates.push_back(Box{
         (int)boxStates.size() + 1,
@@ -103,45 +305,452 @@ void Level::addBox(int x, int y) {
     rebuildCells();
 }
 
+void Level::setTerrain(std::vector<std::pair<int,int>> wallList,
+                       std::vector<std::pair<int,int>> targetList,
+                       const std::vector<std::pair<int,int>>& boxList)
+{
+    auto outside = [this](const std::pair<int,int>& p) { return !isInside(p.first, p.second); };
+
+    wallList.erase(std::remove_if(wallList.begin(), wallList.end(), outside), wallList.end());
+    targetList.erase(std::remove_if(targetList.begin(), targetList.end(), outside), targetList.end());
+
+    Terrain& t = mutableTerrain();
+    t.walls = std::move(wallList);
+    t.targets = std::move(targetList);
+    t.layout = nextLayoutId();
+
+    t.boxesPos.clear();
+    boxStates.clear();
+    for (auto& b : boxList) {
+        if (outside(b)) continue;
+        t.boxesPos.push_back(b);
+        boxStates.push_back(Box{ (int)boxStates.size() + 1, b.first, b.second, false });
+    }
+
+    rebuildBackground();
+    rebuildCells();
+    rebuildRays();
+    rebuildRegions();
+}
+
+void Level::setTerrainBits(const unsigned char* wallBits, size_t wallCount,
+                           std::vector<std::pair<int,int>> targetList,
+                           const std::vector<std::pair<int,int>>& boxList)
+{
+    auto outside = [this](const std::pair<int,int>& p) { return !isInside(p.first, p.second); };
+    targetList.erase(std::remove_if(targetList.begin(), targetList.end(), outside), targetList.end());
+
+    Terrain& t = mutableTerrain();
+    t.targets = std::move(targetList);
+    t.layout = nextLayoutId();
+
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x) {
+            t.grid[y][x] = '.';
+            t.gridCells[y][x].type = CellType::Empty;
+        }
+    std::fill(t.flags.begin(), t.flags.end(), 0);
+
+    // стіни пословно, порожні слова пропускаються; біти за W*H ігноруються
+    const size_t cells = (size_t)width * height;
+    t.walls.clear();
+    t.walls.reserve(wallCount);
+    for (size_t k = 0; k * 64 < cells; ++k) {
+        uint64_t word;
+        std::memcpy(&word, wallBits + k * 8, 8);
+        while (word) {
+            size_t i = k * 64 + ctz64(word);
+            word &= word - 1;
+            if (i >= cells) break;
+
+            int x = (int)(i % width), y = (int)(i / width);
+            t.walls.emplace_back(x, y);
+            t.grid[y][x] = 'X';
+            t.gridCells[y][x].type = CellType::Wall;
+            t.flags[i] |= FlagWall;
+        }
+    }
+
+    t.boxesPos.clear();
+    boxStates.clear();
+    for (auto& b : boxList) {
+        if (outside(b)) continue;
+        t.boxesPos.push_back(b);
+        boxStates.push_back(Box{ (int)boxStates.size() + 1, b.first, b.second, false });
+    }
+
+    // порядок накладання як у rebuildBackground/rebuildCells
+    for (auto& p : t.targets) {
+        t.grid[p.second][p.first] = 'T';
+        t.gridCells[p.second][p.first].type = CellType::Target;
+        t.flags[(size_t)p.second * width + p.first] |= FlagTarget;
+    }
+    for (auto& b : t.boxesPos) {
+        t.grid[b.second][b.first] = 'b';
+        t.flags[(size_t)b.second * width + b.first] |= FlagBox;
+    }
+
+    rebuildRays();
+    rebuildRegions();
+}
+
 bool Level::isInside(int x, int y) const {
     return x >= 0 && y >= 0 && x < width && y < height;
 }
 
 bool Level::isWall(int x, int y) const {
-    return std::find(walls.begin(), walls.end(), std::make_pair(x,y)) != walls.end();
+    return isInside(x,y) && (terrain->flags[(size_t)y * width + x] & FlagWall);
 }
 
 bool Level::isTarget(int x, int y) const {
-    return std::find(targets.begin(), targets.end(), std::make_pair(x,y)) != targets.end();
+    return isInside(x,y) && (terrain->flags[(size_t)y * width + x] & FlagTarget);
 }
 
 bool Level::isBox(int x, int y) const {
-    return std::find(boxesPos.begin(), boxesPos.end(), std::make_pair(x,y)) != boxesPos.end();
+    return isInside(x,y) && (terrain->flags[(size_t)y * width + x] & FlagBox);
+}
+
+int Level::rayDistance(int x, int y, Direction d) const {
+    if (!isInside(x,y)) return 0;
+    return terrain->rays[((size_t)y * width + x) * 4 + (size_t)d];
+}
+
+void Level::rebuildRays() {
+    Terrain& t = mutableTerrain();
+    t.rays.assign((size_t)width * height * 4, 0);
+
+    auto ray = [&](int x, int y, Direction d) -> uint16_t& {
+        return t.rays[((size_t)y * width + x) * 4 + (size_t)d];
+    };
+    auto freeCell = [&](int x, int y) {
+        return !(t.flags[(size_t)y * width + x] & FlagWall);
+    };
+
+    // два проходи на рядок і на стовпець: значення сусіда + 1
+    for (int y = 0; y < height; ++y) {
+        for (int x = 1; x < width; ++x)
+            if (freeCell(x-1, y)) ray(x, y, Direction::Left) = ray(x-1, y, Direction::Left) + 1;
+        for (int x = width - 2; x >= 0; --x)
+            if (freeCell(x+1, y)) ray(x, y, Direction::Right) = ray(x+1, y, Direction::Right) + 1;
+    }
+    for (int x = 0; x < width; ++x) {
+        for (int y = 1; y < height; ++y)
+            if (freeCell(x, y-1)) ray(x, y, Direction::Up) = ray(x, y-1, Direction::Up) + 1;
+        for (int y = height - 2; y >= 0; --y)
+            if (freeCell(x, y+1)) ray(x, y, Direction::Down) = ray(x, y+1, Direction::Down) + 1;
+    }
+}
+
+// після появи стіни в (x, y) промені до неї з її рядка і стовпця обриваються
+void Level::updateRaysAround(int x, int y) {
+    Terrain& t = mutableTerrain();
+    auto ray = [&](int cx, int cy, Direction d) -> uint16_t& {
+        return t.rays[((size_t)cy * width + cx) * 4 + (size_t)d];
+    };
+
+    for (int cx = x - 1; cx >= 0; --cx) {
+        ray(cx, y, Direction::Right) = (uint16_t)(x - cx - 1);
+        if (isWall(cx, y)) break;
+    }
+    for (int cx = x + 1; cx < width; ++cx) {
+        ray(cx, y, Direction::Left) = (uint16_t)(cx - x - 1);
+        if (isWall(cx, y)) break;
+    }
+    for (int cy = y - 1; cy >= 0; --cy) {
+        ray(x, cy, Direction::Down) = (uint16_t)(y - cy - 1);
+        if (isWall(x, cy)) break;
+    }
+    for (int cy = y + 1; cy < height; ++cy) {
+        ray(x, cy, Direction::Up) = (uint16_t)(cy - y - 1);
+        if (isWall(x, cy)) break;
+    }
+}
+
+int Level::componentAt(int x, int y) const {
+    if (!isInside(x,y)) return -1;
+    return terrain->component[(size_t)y * width + x];
+}
+
+int Level::targetDistance(int x, int y) const {
+    if (!isInside(x,y)) return -1;
+    return terrain->targetDist[(size_t)y * width + x];
+}
+
+// області заливкою і відстані до цілей одним BFS від усіх цілей одразу
+void Level::rebuildRegions() {
+    Terrain& t = mutableTerrain();
+    const size_t N = (size_t)width * height;
+    t.component.assign(N, -1);
+    t.targetDist.assign(N, -1);
+
+    const int dx[4] = { 0, 0, -1, 1 };
+    const int dy[4] = { -1, 1, 0, 0 };
+
+    std::vector<size_t> queue;
+    queue.reserve(N);
+
+    auto bfs = [&](std::vector<int32_t>& out, int step) {
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int x = (int)(queue[head] % width);
+            int y = (int)(queue[head] / width);
+            for (int k = 0; k < 4; ++k) {
+                int nx = x + dx[k], ny = y + dy[k];
+                if (!isInside(nx, ny)) continue;
+                size_t ni = (size_t)ny * width + nx;
+                if (out[ni] >= 0 || (t.flags[ni] & FlagWall)) continue;
+                out[ni] = out[queue[head]] + step;
+                queue.push_back(ni);
+            }
+        }
+    };
+
+    int32_t next = 0;
+    for (size_t i = 0; i < N; ++i) {
+        if (t.component[i] >= 0 || (t.flags[i] & FlagWall)) continue;
+        queue.clear();
+        queue.push_back(i);
+        t.component[i] = next++;
+        bfs(t.component, 0);
+    }
+    t.nextComponent = next;
+
+    queue.clear();
+    for (auto& p : t.targets) {
+        size_t i = (size_t)p.second * width + p.first;
+        if (t.targetDist[i] >= 0 || (t.flags[i] & FlagWall)) continue;
+        t.targetDist[i] = 0;
+        queue.push_back(i);
+    }
+    bfs(t.targetDist, 1);
+}
+
+// Стіна в (x, y) може розірвати лише свою область. Якщо вільні сусіди
+// з'єднані в обхід через кільце з 8 клітинок навколо, області не змінюються,
+// інакше частини області заливаються від сусідів заново. Відстані до цілей
+// ростуть лише в клітинок, чиї найкоротші шляхи йшли через (x, y).
+void Level::updateRegionsAroundWall(int x, int y) {
+    Terrain& t = mutableTerrain();
+    const size_t wi = (size_t)y * width + x;
+    const int32_t comp = t.component[wi];
+    const int32_t dist = t.targetDist[wi];
+    t.component[wi] = -1;
+    t.targetDist[wi] = -1;
+
+    const int dx[4] = { 0, 0, -1, 1 };
+    const int dy[4] = { -1, 1, 0, 0 };
+    auto freeCell = [&](int cx, int cy) {
+        return isInside(cx, cy) && !(t.flags[(size_t)cy * width + cx] & FlagWall);
+    };
+
+    // кільце за годинниковою стрілкою; сусідні елементи суміжні,
+    // непарні — сусіди стіни по стороні
+    const int rx[8] = { -1, 0, 1, 1, 1, 0, -1, -1 };
+    const int ry[8] = { -1, -1, -1, 0, 1, 1, 1, 0 };
+    bool ring[8];
+    int blocked = -1;
+    for (int k = 0; k < 8; ++k) {
+        ring[k] = freeCell(x + rx[k], y + ry[k]);
+        if (!ring[k]) blocked = k;
+    }
+
+    // скільки неперервних відрізків кільця містять сусіда по стороні:
+    // один — сусіди з'єднані поруч зі стіною, і область ціла
+    int groups = blocked < 0 ? 1 : 0;
+    for (int n = 1; blocked >= 0 && n <= 8; ) {
+        bool side = false;
+        for (; n <= 8 && ring[(blocked + n) % 8]; ++n)
+            side |= ((blocked + n) % 8) % 2 == 1;
+        if (side) ++groups;
+        ++n;
+    }
+
+    if (groups > 1) {
+        // BFS від кожного сусіда по черзі, по клітинці за крок; пошуки, що
+        // зустрілись, зливаються в групу. Зупинка, коли група лишилась одна
+        // або росте лише одна: решта груп — окремі частини, обійдені цілком,
+        // тож робота пропорційна меншим частинам, а не всій області
+        struct Search { std::vector<size_t> cells; size_t head = 0; };
+        std::vector<Search> search;
+        int parent[4];
+        for (int k = 1; k < 8; k += 2) {
+            if (!ring[k]) continue;
+            size_t c = (size_t)(y + ry[k]) * width + (x + rx[k]);
+            parent[search.size()] = (int)search.size();
+            t.component[c] = -2 - (int32_t)search.size();   // тимчасова мітка пошуку
+            search.push_back({ { c } });
+        }
+        auto root = [&](int i) { while (parent[i] != i) i = parent[i]; return i; };
+        auto growing = [&](int i) { return search[i].head < search[i].cells.size(); };
+        const int m = (int)search.size();
+
+        int kept = -1;
+        for (;;) {
+            int roots = 0, growingRoots = 0, growingRoot = -1;
+            bool grows[4] = {};
+            for (int i = 0; i < m; ++i) {
+                if (parent[i] == i) ++roots;
+                if (growing(i)) grows[root(i)] = true;
+            }
+            for (int i = 0; i < m; ++i)
+                if (grows[i]) { ++growingRoots; growingRoot = i; }
+            if (roots == 1 || growingRoots <= 1) {
+                kept = growingRoots == 1 ? growingRoot : root(0);
+                break;
+            }
+
+            for (int i = 0; i < m; ++i) {
+                if (!growing(i)) continue;
+                size_t v = search[i].cells[search[i].head++];
+                int cx = (int)(v % width), cy = (int)(v / width);
+                for (int k = 0; k < 4; ++k) {
+                    if (!freeCell(cx + dx[k], cy + dy[k])) continue;
+                    size_t ni = (size_t)(cy + dy[k]) * width + (cx + dx[k]);
+                    int32_t c = t.component[ni];
+                    if (c == comp) {
+                        t.component[ni] = -2 - i;
+                        search[i].cells.push_back(ni);
+                    } else if (c <= -2) {
+                        int a = root(i), b = root(-2 - c);
+                        if (a != b) parent[std::max(a, b)] = std::min(a, b);
+                    }
+                }
+            }
+        }
+
+        // група, що ще росла, зберігає старий номер, решта отримують нові
+        int32_t ids[4] = { -1, -1, -1, -1 };
+        for (int i = 0; i < m; ++i) {
+            int r = root(i);
+            if (r != kept && ids[r] < 0) ids[r] = t.nextComponent++;
+            int32_t id = r == kept ? comp : ids[r];
+            for (size_t c : search[i].cells) t.component[c] = id;
+        }
+    }
+
+    if (dist < 0) return;
+
+    // клітинка без сусіда на відстані d - 1 втрачає опору; хвиля йде від
+    // стіни за зростанням d, тож сусіди ближче до цілей уже перевірені
+    std::vector<size_t> queue, lost;
+    for (int k = 0; k < 4; ++k) {
+        if (!freeCell(x + dx[k], y + dy[k])) continue;
+        size_t ni = (size_t)(y + dy[k]) * width + (x + dx[k]);
+        if (t.targetDist[ni] == dist + 1) queue.push_back(ni);
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const size_t v = queue[head];
+        const int32_t d = t.targetDist[v];
+        if (d <= 0) continue;
+
+        int cx = (int)(v % width), cy = (int)(v / width);
+        bool held = false;
+        for (int k = 0; k < 4 && !held; ++k)
+            held = isInside(cx + dx[k], cy + dy[k]) &&
+                   t.targetDist[(size_t)(cy + dy[k]) * width + (cx + dx[k])] == d - 1;
+        if (held) continue;
+
+        t.targetDist[v] = -1;
+        lost.push_back(v);
+        for (int k = 0; k < 4; ++k) {
+            if (!freeCell(cx + dx[k], cy + dy[k])) continue;
+            size_t ni = (size_t)(cy + dy[k]) * width + (cx + dx[k]);
+            if (t.targetDist[ni] == d + 1) queue.push_back(ni);
+        }
+    }
+
+    // нові відстані втраченим — Дейкстрою від меж із клітинками, що лишились
+    using Item = std::pair<int32_t, size_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+    for (size_t v : lost) {
+        int cx = (int)(v % width), cy = (int)(v / width);
+        int32_t best = -1;
+        for (int k = 0; k < 4; ++k) {
+            if (!isInside(cx + dx[k], cy + dy[k])) continue;
+            int32_t d = t.targetDist[(size_t)(cy + dy[k]) * width + (cx + dx[k])];
+            if (d >= 0 && (best < 0 || d + 1 < best)) best = d + 1;
+        }
+        if (best < 0) continue;
+        t.targetDist[v] = best;
+        open.push({ best, v });
+    }
+    while (!open.empty()) {
+        auto [d, v] = open.top();
+        open.pop();
+        if (d != t.targetDist[v]) continue;
+
+        int cx = (int)(v % width), cy = (int)(v / width);
+        for (int k = 0; k < 4; ++k) {
+            if (!freeCell(cx + dx[k], cy + dy[k])) continue;
+            size_t ni = (size_t)(cy + dy[k]) * width + (cx + dx[k]);
+            if (t.targetDist[ni] >= 0 && t.targetDist[ni] <= d + 1) continue;
+            t.targetDist[ni] = d + 1;
+            open.push({ d + 1, ni });
+        }
+    }
+}
+
+// нова ціль лише зменшує відстані: BFS від неї, поки вони зменшуються
+void Level::updateRegionsAroundTarget(int x, int y) {
+    Terrain& t = mutableTerrain();
+    const size_t ti = (size_t)y * width + x;
+    if ((t.flags[ti] & FlagWall) || t.targetDist[ti] == 0) return;
+
+    const int dx[4] = { 0, 0, -1, 1 };
+    const int dy[4] = { -1, 1, 0, 0 };
+
+    t.targetDist[ti] = 0;
+    std::vector<size_t> queue(1, ti);
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int cx = (int)(queue[head] % width);
+        int cy = (int)(queue[head] / width);
+        const int32_t d = t.targetDist[queue[head]] + 1;
+        for (int k = 0; k < 4; ++k) {
+            int nx = cx + dx[k], ny = cy + dy[k];
+            if (!isInside(nx, ny)) continue;
+            size_t ni = (size_t)ny * width + nx;
+            if ((t.flags[ni] & FlagWall) || (t.targetDist[ni] >= 0 && t.targetDist[ni] <= d)) continue;
+            t.targetDist[ni] = d;
+            queue.push_back(ni);
+        }
+    }
 }
 
 void Level::rebuildBackground() {
+    Terrain& t = mutableTerrain();
+
     for (int y = 0; y < height; ++y)
         for (int x = 0; x < width; ++x)
-            grid[y][x] = '.';
+            t.grid[y][x] = '.';
 
-    for (auto& w : walls) grid[w.second][w.first] = 'X';
-    for (auto& t : targets) grid[t.second][t.first] = 'T';
-    for (auto& b : boxesPos)  grid[b.second][b.first] = 'b';
+    for (auto& w : t.walls) t.grid[w.second][w.first] = 'X';
+    for (auto& p : t.targets) t.grid[p.second][p.first] = 'T';
+    for (auto& b : t.boxesPos)  t.grid[b.second][b.first] = 'b';
 }
 
 void Level::rebuildCells() {
+    Terrain& t = mutableTerrain();
+
     for (int y = 0; y < height; ++y)
         for (int x = 0; x < width; ++x)
-            gridCells[y][x].type = CellType::Empty;
+            t.gridCells[y][x].type = CellType::Empty;
+
+    std::fill(t.flags.begin(), t.flags.end(), 0);
 
-    for (auto& w : walls) gridCells[w.second][w.first].type = CellType::Wall;
-    for (auto& t : targets) gridCells[t.second][t.first].type = CellType::Target;
+    for (auto& w : t.walls) {
+        t.gridCells[w.second][w.first].type = CellType::Wall;
+        t.flags[(size_t)w.second * width + w.first] |= FlagWall;
+    }
+    for (auto& p : t.targets) {
+        t.gridCells[p.second][p.first].type = CellType::Target;
+        t.flags[(size_t)p.second * width + p.first] |= FlagTarget;
+    }
+    for (auto& b : t.boxesPos)
+        t.flags[(size_t)b.second * width + b.first] |= FlagBox;
 }
 
 void Level::update() {
+    // рельєф під час ходу не змінюється, сітку не перебудовуємо
     moves++;
-    rebuildBackground();
-    rebuildCells();
 
     for (auto& r : robots) {
         auto* st = r->getState();
@@ -172,10 +781,9 @@ void Level::update() {
     }
 }
 
-std::vector<std::vector<char>> Level::getGrid() const { return grid; }
+std::vector<std::vector<char>> Level::getGrid() const { return terrain->grid; }
 
-std::vector<std::vector<Cell>>& Level::getGridCells() { return gridCells; }
-const std::vector<std::vector<Cell>>& Level::getGridCells() const { return gridCells; }
+const std::vector<std::vector<Cell>>& Level::getGridCells() const { return terrain->gridCells; }
 
 const std::vector<std::unique_ptr<Robot>>& Level::getRobots() const { return robots; }
 std::vector<std::unique_ptr<Robot>>& Level::getRobots() { return robots; }
@@ -184,6 +792,7 @@ std::vector<std::unique_ptr<Robot>>& Level::getPlacedRobots() {return placedRobo
 const std::vector<std::unique_ptr<Robot>>& Level::getPlacedRobots() const {return placedRobots;}
 
 std::vector<std::unique_ptr<RobotState>>& Level::getRobotStates() { return robotStates; }
+const std::vector<std::unique_ptr<RobotState>>& Level::getRobotStates() const { return robotStates; }
 
 std::vector<Box>& Level::getBoxes() { return boxStates; }
 const std::vector<Box>& Level::getBoxes() const { return boxStates; }
@@ -194,9 +803,5 @@ bool Level::isCompleted() const {
 }
 
 const Cell& Level::getCell(int x, int y) const {
-    return gridCells[y][x];
-}
-
-Cell& Level::getCell(int x, int y) {
-    return gridCells[y][x];
+    return terrain->gridCells[y][x];
 }
@@ -3,14 +3,31 @@
 #include <vector>
 #include <memory>
 #include <utility>
+#include <cstdint>
 
 #include "Types.hpp"
 #include "Robot.hpp"
 
+struct TickDelta;
+
 class Level {
 public:
     Level(int w = 10, int h = 10);
 
+    // копія ділить незмінний рельєф і копіює лише динамічний шар
+    Level(const Level& other);
+    Level& operator=(const Level& other);
+    Level(Level&&) = default;
+    Level& operator=(Level&&) = default;
+
+    Level clone() const { return Level(*this); }
+    size_t memoryFootprint() const;
+
+    LevelSnapshot snapshot() const;
+    void restore(const LevelSnapshot& snap);
+    // відкат одного ходу на місці; дельти — від останньої до першої
+    void revert(const TickDelta& d);
+
     void addRobot(std::unique_ptr<Robot> r);
     void addPlacedRobot(std::unique_ptr<Robot> r);
     void clearPlacedRobots();
@@ -19,16 +36,35 @@ public:
     void addTarget(int x, int y);
     void addBox(int x, int y);
 
+    // масове заповнення рельєфу з одним перебудуванням сітки
+    void setTerrain(std::vector<std::pair<int,int>> wallList,
+                    std::vector<std::pair<int,int>> targetList,
+                    const std::vector<std::pair<int,int>>& boxList);
+    // те саме, але стіни — бітова маска W*H біт (uint64 слова, біт y*W + x,
+    // як у .lvlb): клітинки заповнюються прямо з неї, без списку пар
+    void setTerrainBits(const unsigned char* wallBits, size_t wallCount,
+                        std::vector<std::pair<int,int>> targetList,
+                        const std::vector<std::pair<int,int>>& boxList);
+
     bool isInside(int x, int y) const;
     bool isWall(int x, int y) const;
     bool isTarget(int x, int y) const;
     bool isBox(int x, int y) const;
 
+    // скільки клітинок поспіль вільні від стін у напрямку d, починаючи з сусідньої
+    // (0 — попереду стіна або край карти); для клітинок поза картою — 0
+    int rayDistance(int x, int y, Direction d) const;
+    const std::vector<uint16_t>& getRayTable() const { return terrain->rays; }
+
+    // зв'язна область вільних клітинок (4-зв'язність); -1 — стіна або поза картою
+    int componentAt(int x, int y) const;
+    // довжина найкоротшого шляху без стін до найближчої цілі; -1 — недосяжна
+    int targetDistance(int x, int y) const;
+
     void update();
     bool isCompleted() const;
 
     std::vector<std::vector<char>> getGrid() const;
-    std::vector<std::vector<Cell>>& getGridCells();
     const std::vector<std::vector<Cell>>& getGridCells() const;
 
     std::vector<std::unique_ptr<Robot>>& getRobots();
@@ -37,32 +73,55 @@ public:
     const std::vector<std::unique_ptr<Robot>>& getPlacedRobots() const;
 
     std::vector<std::unique_ptr<RobotState>>& getRobotStates();
+    const std::vector<std::unique_ptr<RobotState>>& getRobotStates() const;
 
     std::vector<Box>& getBoxes();
     const std::vector<Box>& getBoxes() const;
 
-    const std::vector<std::pair<int,int>>& getWalls() const { return walls; }
-    const std::vector<std::pair<int,int>>& getTargets() const { return targets; }
+    const std::vector<std::pair<int,int>>& getWalls() const { return terrain->walls; }
+    const std::vector<std::pair<int,int>>& getTargets() const { return terrain->targets; }
 
     int getWidth() const { return width; }
     int getHeight() const { return height; }
 
     int getMoves() const { return moves; }
     void incrementMoves() { ++moves; }
+    void addMoves(int n) { moves += n; }
 
     const Cell& getCell(int x, int y) const;
-    Cell& getCell(int x, int y);
+
+    // true, якщо інший Level ділить з цим той самий рельєф
+    bool sharesTerrainWith(const Level& other) const { return terrain == other.terrain; }
+
+    // Мітка розкладки рельєфу: змінюється при всьому, крім addWall, і при
+    // копіюванні спільного рельєфу перед зміною. Разом із getWalls().size()
+    // дає змогу кешам довантажувати нові стіни.
+    uint64_t layoutId() const { return terrain->layout; }
 
 private:
+    enum : uint8_t { FlagWall = 1, FlagTarget = 2, FlagBox = 4 };
+
+    // Статичний шар рівня. Спільний для копій, копіюється при зміні.
+    struct Terrain {
+        std::vector<std::vector<char>> grid;
+        std::vector<std::vector<Cell>> gridCells;
+        std::vector<uint8_t> flags;   // FlagWall | FlagTarget | FlagBox, y*W + x
+        std::vector<uint16_t> rays;   // (y*W + x)*4 + Direction, див. rayDistance
+        std::vector<int32_t> component;   // y*W + x, див. componentAt
+        std::vector<int32_t> targetDist;  // y*W + x, див. targetDistance
+        int32_t nextComponent = 0;        // номер для області, що відкололась
+
+        std::vector<std::pair<int,int>> walls;
+        std::vector<std::pair<int,int>> targets;
+        std::vector<std::pair<int,int>> boxesPos;
+
+        uint64_t layout = 0;   // див. layoutId
+    };
+
     int width, height;
     int moves = 0;
 
-    std::vector<std::vector<char>> grid;
-    std::vector<std::vector<Cell>> gridCells;
-
-    std::vector<std::pair<int,int>> walls;
-    std::vector<std::pair<int,int>> targets;
-    std::vector<std::pair<int,int>> boxesPos;
+    std::shared_ptr<Terrain> terrain;
 
     std::vector<Box> boxStates;
 
@@ -71,6 +130,15 @@ private:
 
     std::vector<std::unique_ptr<RobotState>> robotStates;
 
+    Terrain& mutableTerrain();
+    size_t stateIndex(const RobotState* s) const;
+    std::unique_ptr<Robot> makeListed(size_t index, bool hasCommand, const Command& command);
+
     void rebuildBackground();
     void rebuildCells();
+    void rebuildRays();
+    void updateRaysAround(int x, int y);
+    void rebuildRegions();
+    void updateRegionsAroundWall(int x, int y);
+    void updateRegionsAroundTarget(int x, int y);
 };
@@ -0,0 +1,89 @@
+#include "LevelBinary.hpp"
+#include "LevelLoader.hpp"
+#include "Hash.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+template <typename T>
+static void appendPod(std::vector<unsigned char>& out, const T& v) {
+    auto* p = reinterpret_cast<const unsigned char*>(&v);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+std::vector<unsigned char> LevelCompiler::compile(const Level& lvl) {
+    const int W = lvl.getWidth();
+    const int H = lvl.getHeight();
+
+    LevelFileHeader hdr{};
+    std::memcpy(hdr.magic, LEVEL_FILE_MAGIC, 4);
+    hdr.version = LEVEL_FILE_VERSION;
+    hdr.width   = W;
+    hdr.height  = H;
+
+    std::vector<unsigned char> out(sizeof(LevelFileHeader));
+
+    // стіни — упаковані біти
+    std::vector<uint64_t> bits(((size_t)W * H + 63) / 64, 0);
+    for (auto& w : lvl.getWalls()) {
+        size_t i = (size_t)w.second * W + w.first;
+        if (!(bits[i / 64] >> (i % 64) & 1)) ++hdr.wallCount;
+        bits[i / 64] |= 1ull << (i % 64);
+    }
+    hdr.wallsOffset = out.size();
+    for (uint64_t word : bits) appendPod(out, word);
+
+    hdr.targetsOffset = out.size();
+    for (auto& t : lvl.getTargets()) {
+        appendPod(out, (int32_t)t.first);
+        appendPod(out, (int32_t)t.second);
+        ++hdr.targetCount;
+    }
+
+    hdr.boxesOffset = out.size();
+    for (auto& b : lvl.getBoxes()) {
+        appendPod(out, (int32_t)b.x);
+        appendPod(out, (int32_t)b.y);
+        ++hdr.boxCount;
+    }
+
+    hdr.robotsOffset = out.size();
+    for (auto& r : lvl.getRobots()) {
+        auto* s = r->getState();
+        if (!s) continue;
+
+        LevelFileRobot fr{};
+        fr.x    = s->x;
+        fr.y    = s->y;
+        fr.type = (uint8_t)s->type;
+        fr.dir  = (uint8_t)s->dir;
+        appendPod(out, fr);
+        ++hdr.robotCount;
+    }
+
+    hdr.fileSize = out.size();
+    hdr.contentHash = fnv1a64(out.data() + sizeof(LevelFileHeader),
+                              out.size() - sizeof(LevelFileHeader));
+
+    std::memcpy(out.data(), &hdr, sizeof(hdr));
+    return out;
+}
+
+bool LevelCompiler::compileFile(const std::string& jsonPath, const std::string& outPath) {
+    auto lvl = LevelLoader::loadFromJson(jsonPath);
+    if (!lvl) {
+        std::cerr << "Cannot load level: " << jsonPath << std::endl;
+        return false;
+    }
+
+    auto bytes = compile(*lvl);
+
+    std::ofstream f(outPath, std::ios::binary | std::ios::trunc);
+    if (!f.is_open()) {
+        std::cerr << "Cannot write file: " << outPath << std::endl;
+        return false;
+    }
+
+    f.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    return (bool)f;
+}
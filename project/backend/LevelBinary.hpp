@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Level.hpp"
+
+// Бінарний формат рівня (.lvlb), little-endian:
+//   LevelFileHeader
+//   стіни   — бітова маска W*H біт (uint64 слова, біт y*W + x)
+//   цілі    — int32 пари (x, y)
+//   коробки — int32 пари (x, y)
+//   роботи  — LevelFileRobot
+// contentHash — FNV-1a усіх байтів після заголовка.
+
+constexpr char     LEVEL_FILE_MAGIC[4] = { 'O', 'O', 'P', 'L' };
+constexpr uint32_t LEVEL_FILE_VERSION  = 1;
+
+#pragma pack(push, 1)
+struct LevelFileHeader {
+    char     magic[4];
+    uint32_t version;
+    int32_t  width;
+    int32_t  height;
+    uint32_t wallCount;
+    uint32_t targetCount;
+    uint32_t boxCount;
+    uint32_t robotCount;
+    uint64_t contentHash;
+    uint64_t wallsOffset;
+    uint64_t targetsOffset;
+    uint64_t boxesOffset;
+    uint64_t robotsOffset;
+    uint64_t fileSize;
+};
+
+struct LevelFileRobot {
+    int32_t x;
+    int32_t y;
+    uint8_t type;   // RobotType
+    uint8_t dir;    // Direction
+    uint8_t reserved[2];
+};
+#pragma pack(pop)
+
+class LevelCompiler {
+public:
+    static std::vector<unsigned char> compile(const Level& lvl);
+    static bool compileFile(const std::string& jsonPath, const std::string& outPath);
+};
@@ -0,0 +1,121 @@
+#include "LevelCache.hpp"
+#include "LevelLoader.hpp"
+#include "LevelBinary.hpp"
+#include "MappedFile.hpp"
+#include "Hash.hpp"
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+LevelCache::LevelCache(size_t capacityBytes) : capacity_(capacityBytes) {}
+
+void LevelCache::setCapacity(size_t bytes) {
+    capacity_ = bytes;
+    evict();
+}
+
+void LevelCache::clear() {
+    lru_.clear();
+    index_.clear();
+    used_ = 0;
+}
+
+void LevelCache::touch(std::list<Entry>::iterator it) {
+    lru_.splice(lru_.begin(), lru_, it);
+}
+
+void LevelCache::erase(std::list<Entry>::iterator it) {
+    used_ -= it->bytes;
+    index_.erase(it->key);
+    lru_.erase(it);
+}
+
+void LevelCache::evict() {
+    while (used_ > capacity_ && !lru_.empty())
+        erase(std::prev(lru_.end()));
+}
+
+std::optional<Level> LevelCache::load(const std::string& path) {
+    if (capacity_ == 0)
+        return LevelLoader::load(path);
+
+    std::error_code ec;
+    fs::path p = fs::u8path(path);
+    std::string key = fs::weakly_canonical(p, ec).u8string();
+    if (ec) key = path;
+
+    auto ftime = fs::last_write_time(p, ec);
+    uint64_t fsize = ec ? 0 : (uint64_t)fs::file_size(p, ec);
+    if (ec)
+        return LevelLoader::load(path);
+    int64_t mtime = (int64_t)ftime.time_since_epoch().count();
+
+    auto found = index_.find(key);
+
+    // 1) файл не змінювався — відразу копія шаблону
+    if (found != index_.end() &&
+        found->second->mtime == mtime && found->second->fileSize == fsize)
+    {
+        ++hits_;
+        touch(found->second);
+        return found->second->level->clone();
+    }
+
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Cannot open file: " << path << std::endl;
+        return std::nullopt;
+    }
+    // для .lvlb хеш вмісту вже є в заголовку — файл не хешується вдруге,
+    // loadFromBinary перевірить його лише при промаху
+    bool binary = file.size() >= sizeof(LevelFileHeader) &&
+                  std::memcmp(file.data(), LEVEL_FILE_MAGIC, 4) == 0;
+    uint64_t hash;
+    if (binary) {
+        LevelFileHeader hdr;
+        std::memcpy(&hdr, file.data(), sizeof(hdr));
+        hash = hdr.contentHash;
+    } else {
+        hash = fnv1a64(file.data(), file.size());
+    }
+
+    // 2) mtime змінився, а вміст — ні
+    if (found != index_.end() && found->second->contentHash == hash) {
+        ++hits_;
+        found->second->mtime = mtime;
+        found->second->fileSize = fsize;
+        touch(found->second);
+        return found->second->level->clone();
+    }
+
+    // 3) промах — повний розбір
+    ++misses_;
+
+    auto lvl = binary
+        ? LevelLoader::loadFromBinary(file.data(), file.size())
+        : LevelLoader::loadFromJsonText(reinterpret_cast<const char*>(file.data()), file.size());
+    if (!lvl) return std::nullopt;
+
+    if (found != index_.end())
+        erase(found->second);
+
+    Entry e;
+    e.key = key;
+    e.mtime = mtime;
+    e.fileSize = fsize;
+    e.contentHash = hash;
+    e.bytes = lvl->memoryFootprint();
+
+    if (e.bytes > capacity_)
+        return lvl;
+
+    e.level = std::make_shared<const Level>(lvl->clone());
+    used_ += e.bytes;
+    lru_.push_front(std::move(e));
+    index_[key] = lru_.begin();
+    evict();
+
+    return lvl;
+}
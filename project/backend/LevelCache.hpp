@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "Level.hpp"
+
+// Кеш розібраних рівнів: ключ — канонічний шлях, mtime та хеш вмісту.
+// Зберігаються незмінні шаблони, load() повертає їхню копію.
+class LevelCache {
+public:
+    explicit LevelCache(size_t capacityBytes = 64ull << 20);
+
+    std::optional<Level> load(const std::string& path);
+
+    void setCapacity(size_t bytes);
+    size_t capacity() const { return capacity_; }
+    size_t bytesUsed() const { return used_; }
+    size_t entries() const { return lru_.size(); }
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+    void clear();
+
+private:
+    struct Entry {
+        std::string key;
+        int64_t mtime = 0;
+        uint64_t fileSize = 0;
+        uint64_t contentHash = 0;
+        size_t bytes = 0;
+        std::shared_ptr<const Level> level;
+    };
+
+    size_t capacity_;
+    size_t used_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+
+    std::list<Entry> lru_;   // спереду — найсвіжіші
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+
+    void touch(std::list<Entry>::iterator it);
+    void erase(std::list<Entry>::iterator it);
+    void evict();
+};
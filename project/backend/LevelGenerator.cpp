@@ -0,0 +1,110 @@
+#include "LevelGenerator.hpp"
+#include "GameEngine.hpp"
+#include "WorkerRobot.hpp"
+#include "ControllerRobot.hpp"
+
+#include <algorithm>
+#include <random>
+#include <unordered_set>
+
+using json = nlohmann::json;
+
+LevelGenerator::LevelGenerator(LevelGenOptions opt) : opt_(opt) {}
+
+std::optional<Level> LevelGenerator::generate(uint64_t seed, int* attempts) const {
+    const int W = std::max(1, opt_.width), H = std::max(1, opt_.height);
+    const long cells = (long)W * H;
+    const int objects = std::max(0, opt_.boxes) + std::max(0, opt_.targets)
+                      + std::max(0, opt_.workers) + std::max(0, opt_.controllers);
+    const uint64_t wallBelow = (uint64_t)(std::clamp(opt_.wallDensity, 0.0, 1.0) * 1000000.0);
+
+    std::mt19937_64 rng(seed);
+    for (int attempt = 1; attempt <= std::max(1, opt_.maxAttempts); ++attempt) {
+        if (attempts) *attempts = attempt;
+
+        std::vector<std::pair<int,int>> walls;
+        std::vector<char> wall(cells, 0);
+        for (long c = 0; c < cells; ++c) {
+            if (rng() % 1000000 >= wallBelow) continue;
+            wall[c] = 1;
+            walls.emplace_back((int)(c % W), (int)(c / W));
+        }
+        if (cells - (long)walls.size() < objects) continue;
+
+        // різні вільні клітинки вибіркою з відкиданням: об'єктів зазвичай
+        // набагато менше, ніж клітинок
+        std::unordered_set<long> used;
+        auto pick = [&](int n) {
+            std::vector<std::pair<int,int>> out;
+            while ((int)out.size() < n) {
+                long c = (long)(rng() % (uint64_t)cells);
+                if (wall[c] || !used.insert(c).second) continue;
+                out.emplace_back((int)(c % W), (int)(c / W));
+            }
+            return out;
+        };
+        auto targets = pick(std::max(0, opt_.targets));
+        auto boxes = pick(std::max(0, opt_.boxes));
+        auto workers = pick(std::max(0, opt_.workers));
+        auto controllers = pick(std::max(0, opt_.controllers));
+
+        Level lvl(W, H);
+        lvl.setTerrain(std::move(walls), std::move(targets), boxes);
+        for (auto& [x, y] : workers) {
+            auto r = std::make_unique<WorkerRobot>();
+            r->setPosition(x, y);
+            lvl.addRobot(std::move(r));
+        }
+        for (auto& [x, y] : controllers) {
+            auto r = std::make_unique<ControllerRobot>();
+            r->setPosition(x, y);
+            lvl.addRobot(std::move(r));
+        }
+
+        if (opt_.reachableOnly && !reachable(lvl)) continue;
+        return lvl;
+    }
+    return std::nullopt;
+}
+
+bool LevelGenerator::reachable(const Level& lvl) {
+    GameEngine::HopelessInput in;
+    in.manualCommands = true;        // без поворотів лише область вирішує досяжність
+    in.boxes = &lvl.getBoxes();
+    for (auto& r : lvl.getRobots()) {
+        auto* s = r->getState();
+        if (s && s->alive && s->type == RobotType::Worker)
+            in.workers.push_back({ s->x, s->y, s->dir, false, -1 });
+    }
+
+    // без робітників hopelessFor лишає поразку isLose, а тут це просто «ні»
+    if (in.workers.empty()) return lvl.isCompleted();
+    return !GameEngine::hopelessFor(lvl, in);
+}
+
+json LevelGenerator::levelToJson(const Level& lvl) {
+    json walls = json::array(), targets = json::array(), boxes = json::array(), robots = json::array();
+    for (auto& w : lvl.getWalls()) walls.push_back({ w.first, w.second });
+    for (auto& t : lvl.getTargets()) targets.push_back({ t.first, t.second });
+    for (auto& b : lvl.getBoxes()) boxes.push_back({ b.x, b.y });
+    for (auto& r : lvl.getRobots()) {
+        auto* s = r->getState();
+        if (!s) continue;
+        robots.push_back({
+            {"type", s->type == RobotType::Worker ? "worker" : "controller"},
+            {"x", s->x},
+            {"y", s->y}
+        });
+    }
+
+    return json{
+        {"width", lvl.getWidth()},
+        {"height", lvl.getHeight()},
+        {"world", {
+            {"walls", walls},
+            {"targets", targets},
+            {"boxes", boxes},
+            {"robots", robots}
+        }}
+    };
+}
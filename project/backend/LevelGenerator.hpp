@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <nlohmann/json.hpp>
+#include "Level.hpp"
+
+struct LevelGenOptions {
+    int width = 10;
+    int height = 10;
+    double wallDensity = 0.2;         // частка клітинок-стін
+    int boxes = 1;
+    int targets = 1;
+    int workers = 1;
+    int controllers = 0;
+    bool reachableOnly = false;       // лише рівні, де кожну коробку може довезти якийсь робітник
+    int maxAttempts = 100;            // спроб на seed, поки рівень не пройде фільтр
+};
+
+// Випадкові рівні заданого розміру. Той самий seed дає той самий рівень
+// на будь-якій платформі: лише mt19937_64 і взяття за модулем, без
+// розподілів стандартної бібліотеки, що різняться між реалізаціями.
+// Коробки, цілі й роботи стоять у різних вільних клітинках.
+class LevelGenerator {
+public:
+    explicit LevelGenerator(LevelGenOptions opt = {});
+
+    // nullopt — вільних клітинок замало або жодна спроба не пройшла фільтр;
+    // attempts — скільки спроб знадобилось
+    std::optional<Level> generate(uint64_t seed, int* attempts = nullptr) const;
+
+    // досяжність так, як її бачить GameEngine: кожна коробка має шлях до цілі
+    // і робітника у своїй області
+    static bool reachable(const Level& lvl);
+
+    // формат рівня з frontend/levels ("world")
+    static nlohmann::json levelToJson(const Level& lvl);
+
+private:
+    LevelGenOptions opt_;
+};
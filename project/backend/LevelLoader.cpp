@@ -2,22 +2,50 @@
 #include "Level.hpp"
 #include "WorkerRobot.hpp"
 #include "ControllerRobot.hpp"
+#include "LevelBinary.hpp"
+#include "MappedFile.hpp"
+#include "Hash.hpp"
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <iostream>
 #include <codecvt>
+#include <cstring>
 
 using json = nlohmann::json;
 
-std::optional<Level> LevelLoader::loadFromJson(const std::string& path) {
+static std::ifstream openInput(const std::string& path) {
     #ifdef _WIN32
         // конвертуємо UTF-8 → UTF-16 (Windows wide path)
         std::wstring ws = std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>>{}.from_bytes(path);
 
-        std::ifstream f(ws, std::ios::binary);
+        return std::ifstream(ws, std::ios::binary);
     #else
-        std::ifstream f(path, std::ios::binary);
+        return std::ifstream(path, std::ios::binary);
     #endif
+}
+
+static std::unique_ptr<Robot> makeRobot(RobotType type) {
+    if (type == RobotType::Worker) return std::make_unique<WorkerRobot>();
+    return std::make_unique<ControllerRobot>();
+}
+
+static std::optional<Level> levelFromJson(const json& j);
+
+std::optional<Level> LevelLoader::load(const std::string& path) {
+    if (isBinaryLevel(path))
+        return loadFromBinary(path);
+    return loadFromJson(path);
+}
+
+bool LevelLoader::isBinaryLevel(const std::string& path) {
+    std::ifstream f = openInput(path);
+    char magic[4] = {};
+    if (!f.read(magic, 4)) return false;
+    return std::memcmp(magic, LEVEL_FILE_MAGIC, 4) == 0;
+}
+
+std::optional<Level> LevelLoader::loadFromJson(const std::string& path) {
+    std::ifstream f = openInput(path);
 
     if (!f.is_open()) {
         std::cerr << "Cannot open file: " << path << std::endl;
@@ -28,17 +56,33 @@ std::optional<Level> LevelLoader::loadFromJson(const std::string& path) {
     try { f >> j; }
     catch (...) { return std::nullopt; }
 
+    return levelFromJson(j);
+}
+
+std::optional<Level> LevelLoader::loadFromJsonText(const char* data, size_t size) {
+    json j;
+    try { j = json::parse(data, data + size); }
+    catch (...) { return std::nullopt; }
+
+    return levelFromJson(j);
+}
+
+static std::optional<Level> levelFromJson(const json& j) {
     int W = j.value("width", 10);
     int H = j.value("height", 10);
     Level lvl(W, H);
 
     if (j.contains("world")) {
-        auto &w = j["world"];
-        if (w.contains("walls")) for (auto &p : w["walls"]) lvl.addWall(p[0], p[1]);
-        if (w.contains("targets")) for (auto &p : w["targets"]) lvl.addTarget(p[0], p[1]);
-        if (w.contains("boxes")) for (auto &p : w["boxes"]) lvl.addBox(p[0], p[1]);
+        auto &w = j.at("world");
+
+        std::vector<std::pair<int,int>> walls, targets, boxes;
+        if (w.contains("walls")) for (auto &p : w.at("walls")) walls.emplace_back(p[0], p[1]);
+        if (w.contains("targets")) for (auto &p : w.at("targets")) targets.emplace_back(p[0], p[1]);
+        if (w.contains("boxes")) for (auto &p : w.at("boxes")) boxes.emplace_back(p[0], p[1]);
+        lvl.setTerrain(std::move(walls), std::move(targets), boxes);
+
         if (w.contains("robots")) {
-            for (auto &r : w["robots"]) {
+            for (auto &r : w.at("robots")) {
                 std::string type = r.value("type", "worker");
                 int x = r.value("x", 0);
                 int y = r.value("y", 0);
@@ -69,4 +113,95 @@ std::optional<Level> LevelLoader::loadFromJson(const std::string& path) {
     }*/
 
     return lvl;
-}
\ No newline at end of file
+}
+
+std::optional<Level> LevelLoader::loadFromBinary(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Cannot open file: " << path << std::endl;
+        return std::nullopt;
+    }
+    return loadFromBinary(file.data(), file.size());
+}
+
+bool LevelLoader::binaryHashMatches(const unsigned char* data, size_t size) {
+    if (size < sizeof(LevelFileHeader)) return false;
+
+    LevelFileHeader hdr;
+    std::memcpy(&hdr, data, sizeof(hdr));
+    return fnv1a64(data + sizeof(hdr), size - sizeof(hdr)) == hdr.contentHash;
+}
+
+std::optional<Level> LevelLoader::loadFromBinary(const unsigned char* data, size_t size,
+                                                 bool verifyHash)
+{
+    if (size < sizeof(LevelFileHeader)) return std::nullopt;
+
+    LevelFileHeader hdr;
+    std::memcpy(&hdr, data, sizeof(hdr));
+
+    if (std::memcmp(hdr.magic, LEVEL_FILE_MAGIC, 4) != 0) return std::nullopt;
+    if (hdr.version != LEVEL_FILE_VERSION) {
+        std::cerr << "Unsupported level version: " << hdr.version << std::endl;
+        return std::nullopt;
+    }
+    if (hdr.width <= 0 || hdr.height <= 0 || hdr.fileSize != size) return std::nullopt;
+
+    const size_t W = (size_t)hdr.width;
+    const size_t H = (size_t)hdr.height;
+    const size_t wordCount = (W * H + 63) / 64;
+
+    auto fits = [&](uint64_t off, uint64_t bytes) {
+        return off <= size && bytes <= size - off;
+    };
+    if (!fits(hdr.wallsOffset,   wordCount * 8) ||
+        !fits(hdr.targetsOffset, (uint64_t)hdr.targetCount * 8) ||
+        !fits(hdr.boxesOffset,   (uint64_t)hdr.boxCount * 8) ||
+        !fits(hdr.robotsOffset,  (uint64_t)hdr.robotCount * sizeof(LevelFileRobot)))
+        return std::nullopt;
+
+    if (verifyHash && !binaryHashMatches(data, size)) {
+        std::cerr << "Level content hash mismatch" << std::endl;
+        return std::nullopt;
+    }
+
+    // тип і напрямок — байти з файлу: напрямок індексує таблицю променів,
+    // а координати — сітку рівня
+    for (uint32_t i = 0; i < hdr.robotCount; ++i) {
+        LevelFileRobot fr;
+        std::memcpy(&fr, data + hdr.robotsOffset + i * sizeof(LevelFileRobot), sizeof(fr));
+        if (fr.type > (uint8_t)RobotType::Controller || fr.dir > (uint8_t)Direction::Right ||
+            fr.x < 0 || fr.y < 0 || fr.x >= hdr.width || fr.y >= hdr.height)
+        {
+            std::cerr << "Invalid robot in level file" << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    auto readPairs = [&](uint64_t off, uint32_t count) {
+        std::vector<std::pair<int,int>> out(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            int32_t xy[2];
+            std::memcpy(xy, data + off + i * 8, 8);
+            out[i] = { xy[0], xy[1] };
+        }
+        return out;
+    };
+
+    Level lvl(hdr.width, hdr.height);
+    lvl.setTerrainBits(data + hdr.wallsOffset, hdr.wallCount,
+                       readPairs(hdr.targetsOffset, hdr.targetCount),
+                       readPairs(hdr.boxesOffset, hdr.boxCount));
+
+    for (uint32_t i = 0; i < hdr.robotCount; ++i) {
+        LevelFileRobot fr;
+        std::memcpy(&fr, data + hdr.robotsOffset + i * sizeof(LevelFileRobot), sizeof(fr));
+
+        auto rp = makeRobot((RobotType)fr.type);
+        rp->setPosition(fr.x, fr.y);
+        rp->setDirection((Direction)fr.dir);
+        lvl.addRobot(std::move(rp));
+    }
+
+    return lvl;
+}
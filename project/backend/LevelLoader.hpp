@@ -5,5 +5,17 @@
 
 class LevelLoader {
 public:
+    // .lvlb (за сигнатурою) або JSON
+    static std::optional<Level> load(const std::string& path);
+
     static std::optional<Level> loadFromJson(const std::string& path);
-};
\ No newline at end of file
+    static std::optional<Level> loadFromJsonText(const char* data, size_t size);
+    static std::optional<Level> loadFromBinary(const std::string& path);
+    // verifyHash = false — вміст уже перевірено binaryHashMatches
+    // (журнал відтворення перевіряє свої рівні один раз при відкритті)
+    static std::optional<Level> loadFromBinary(const unsigned char* data, size_t size,
+                                               bool verifyHash = true);
+    static bool binaryHashMatches(const unsigned char* data, size_t size);
+
+    static bool isBinaryLevel(const std::string& path);
+};
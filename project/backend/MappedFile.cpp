@@ -0,0 +1,86 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <codecvt>
+    #include <locale>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    std::wstring ws = std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>>{}.from_bytes(path);
+
+    HANDLE f = CreateFileW(ws.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(f, &sz) || sz.QuadPart == 0) {
+        CloseHandle(f);
+        return false;
+    }
+
+    HANDLE m = CreateFileMappingW(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) {
+        CloseHandle(f);
+        return false;
+    }
+
+    void* p = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!p) {
+        CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+
+    file_ = f;
+    mapping_ = m;
+    data_ = static_cast<const unsigned char*>(p);
+    size_ = (size_t)sz.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+
+    data_ = static_cast<const unsigned char*>(p);
+    size_ = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!data_) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle((HANDLE)mapping_);
+    CloseHandle((HANDLE)file_);
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+}
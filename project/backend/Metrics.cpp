@@ -0,0 +1,282 @@
+#include "Metrics.hpp"
+#include "GameEngine.hpp"
+#include "Bits.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using json = nlohmann::json;
+
+namespace {
+
+// кожен шард має одного записувача, тож lock-префікс не потрібен
+inline void bump(std::atomic<uint64_t>& a, uint64_t n) {
+    a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// межі кошиків для Prometheus: 1-2.5-5 від 1 мкс до 10 с
+struct Bound { uint64_t ns; const char* le; };
+const Bound PromBounds[] = {
+    { 1000, "1e-06" }, { 2500, "2.5e-06" }, { 5000, "5e-06" },
+    { 10000, "1e-05" }, { 25000, "2.5e-05" }, { 50000, "5e-05" },
+    { 100000, "0.0001" }, { 250000, "0.00025" }, { 500000, "0.0005" },
+    { 1000000, "0.001" }, { 2500000, "0.0025" }, { 5000000, "0.005" },
+    { 10000000, "0.01" }, { 25000000, "0.025" }, { 50000000, "0.05" },
+    { 100000000, "0.1" }, { 250000000, "0.25" }, { 500000000, "0.5" },
+    { 1000000000, "1" }, { 2500000000, "2.5" }, { 5000000000, "5" },
+    { 10000000000, "10" },
+};
+
+std::atomic<uint64_t> nextMetricsId{1};
+
+} // namespace
+
+int Metrics::actionIndex(std::string_view action) {
+    // дій мало, а довжини майже всі різні: порівняння string_view спершу
+    // перевіряє довжину, тож перебір швидший за хеш рядка
+    for (int i = 0; i < (int)ActionNames.size(); ++i)
+        if (action == ActionNames[i])
+            return i;
+    return Other;
+}
+
+const char* Metrics::actionName(int index) {
+    return index >= 0 && index < Other ? ActionNames[index].data() : "other";
+}
+
+int Metrics::bucketOf(uint64_t ns) {
+    ns = std::min<uint64_t>(ns, (1ull << MaxBits) - 1);
+    if (ns < SubBuckets) return (int)ns;
+    int top = msb64(ns);
+    int shift = top - SubBits;
+    return (shift + 1) * SubBuckets + (int)((ns >> shift) & (SubBuckets - 1));
+}
+
+uint64_t Metrics::bucketUpper(int bucket) {
+    if (bucket < SubBuckets) return (uint64_t)bucket;
+    int shift = bucket / SubBuckets - 1;
+    uint64_t low = (uint64_t)(SubBuckets + bucket % SubBuckets) << shift;
+    return low + (1ull << shift) - 1;
+}
+
+Metrics::Metrics()
+    : started_(std::chrono::steady_clock::now()), id_(nextMetricsId++) {}
+
+Metrics::~Metrics() {
+    stopFileDump();
+}
+
+Metrics::Shard& Metrics::shard() {
+    // по шарду на пару (потік, Metrics), останній використаний — першим.
+    // Ключ — id, а не адреса: новий Metrics на місці знищеного не отримає
+    // чужий шард, а записи знищених просто більше не збігаються
+    thread_local std::vector<std::pair<uint64_t, Shard*>> owned;
+    if (!owned.empty() && owned.front().first == id_) return *owned.front().second;
+    for (size_t k = 1; k < owned.size(); ++k) {
+        if (owned[k].first != id_) continue;
+        std::swap(owned.front(), owned[k]);
+        return *owned.front().second;
+    }
+
+    std::lock_guard<std::mutex> lock(shardsMutex_);
+    shards_.push_back(std::make_unique<Shard>());
+    owned.insert(owned.begin(), { id_, shards_.back().get() });
+    return *owned.front().second;
+}
+
+void Metrics::record(int action, uint64_t latencyNs, size_t bytesIn, size_t bytesOut, bool error) {
+    Shard& s = shard();
+    Histogram& h = s.actions[std::clamp(action, 0, Other)];
+    bump(h.counts[bucketOf(latencyNs)], 1);
+    bump(h.count, 1);
+    bump(h.sumNs, latencyNs);
+    if (latencyNs > h.maxNs.load(std::memory_order_relaxed))
+        h.maxNs.store(latencyNs, std::memory_order_relaxed);
+    if (error) bump(h.errors, 1);
+    bump(s.bytesIn, bytesIn);
+    bump(s.bytesOut, bytesOut);
+}
+
+void Metrics::observeEngine(const GameEngine& eng) {
+    const Level& lvl = eng.getLevel();
+    int moves = lvl.getMoves();
+    if (moves > lastMoves_) bump(ticks_, (uint64_t)(moves - lastMoves_));
+    lastMoves_ = moves;
+
+    tick_.store((uint64_t)std::max(0, moves), std::memory_order_relaxed);
+    robots_.store(lvl.getRobots().size() + lvl.getPlacedRobots().size(), std::memory_order_relaxed);
+}
+
+std::unique_ptr<Metrics::Totals> Metrics::collect() const {
+    auto t = std::make_unique<Totals>();
+    std::lock_guard<std::mutex> lock(shardsMutex_);
+    for (auto& s : shards_) {
+        for (int a = 0; a < ActionCount; ++a) {
+            const Histogram& h = s->actions[a];
+            uint64_t n = h.count.load(std::memory_order_relaxed);
+            if (n == 0) continue;
+            for (int b = 0; b < Buckets; ++b)
+                t->counts[a][b] += h.counts[b].load(std::memory_order_relaxed);
+            t->count[a] += n;
+            t->sumNs[a] += h.sumNs.load(std::memory_order_relaxed);
+            t->maxNs[a] = std::max(t->maxNs[a], h.maxNs.load(std::memory_order_relaxed));
+            t->errors[a] += h.errors.load(std::memory_order_relaxed);
+        }
+        t->bytesIn += s->bytesIn.load(std::memory_order_relaxed);
+        t->bytesOut += s->bytesOut.load(std::memory_order_relaxed);
+    }
+    return t;
+}
+
+double Metrics::quantileNs(const Totals& t, int action, double q) {
+    // кошики читаються не атомарно разом з count, тож ранг рахуємо від їхньої суми
+    uint64_t total = 0;
+    for (uint64_t c : t.counts[action]) total += c;
+    if (total == 0) return 0;
+
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * (double)total + 0.5));
+    uint64_t seen = 0;
+    for (int b = 0; b < Buckets; ++b) {
+        seen += t.counts[action][b];
+        if (seen >= rank) return (double)std::min(bucketUpper(b), t.maxNs[action]);
+    }
+    return (double)t.maxNs[action];
+}
+
+json Metrics::toJson() const {
+    auto t = collect();
+    double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+
+    uint64_t requests = 0, errors = 0;
+    json actions = json::object();
+    for (int a = 0; a < ActionCount; ++a) {
+        if (t->count[a] == 0) continue;
+        requests += t->count[a];
+        errors += t->errors[a];
+        actions[actionName(a)] = {
+            {"count", t->count[a]},
+            {"errors", t->errors[a]},
+            {"mean_us", t->sumNs[a] / 1e3 / (double)t->count[a]},
+            {"p50_us", quantileNs(*t, a, 0.50) / 1e3},
+            {"p90_us", quantileNs(*t, a, 0.90) / 1e3},
+            {"p99_us", quantileNs(*t, a, 0.99) / 1e3},
+            {"p999_us", quantileNs(*t, a, 0.999) / 1e3},
+            {"max_us", t->maxNs[a] / 1e3}
+        };
+    }
+
+    return json{
+        {"uptime_seconds", uptime},
+        {"requests", requests},
+        {"errors", errors},
+        {"bytes_in", t->bytesIn},
+        {"bytes_out", t->bytesOut},
+        {"ticks_total", ticks_.load(std::memory_order_relaxed)},
+        {"tick", tick_.load(std::memory_order_relaxed)},
+        {"robots_alive", robots_.load(std::memory_order_relaxed)},
+        {"actions", actions}
+    };
+}
+
+std::string Metrics::toPrometheus() const {
+    auto t = collect();
+    double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+    std::ostringstream out;
+
+    auto header = [&](const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << ' ' << help << '\n' << "# TYPE " << name << ' ' << type << '\n';
+    };
+    auto label = [](int a) { return std::string("{action=\"") + actionName(a) + "\""; };
+
+    header("oop_requests_total", "counter", "Requests handled, by action.");
+    for (int a = 0; a < ActionCount; ++a)
+        if (t->count[a]) out << "oop_requests_total" << label(a) << "} " << t->count[a] << '\n';
+
+    header("oop_request_errors_total", "counter", "Requests answered with status error, by action.");
+    for (int a = 0; a < ActionCount; ++a)
+        if (t->count[a]) out << "oop_request_errors_total" << label(a) << "} " << t->errors[a] << '\n';
+
+    // кошик HDR іде під першу межу, що не менша за його верхнє значення
+    header("oop_request_duration_seconds", "histogram",
+           "Time from reading a request line to writing its response.");
+    for (int a = 0; a < ActionCount; ++a) {
+        if (!t->count[a]) continue;
+        uint64_t cumulative = 0;
+        int b = 0;
+        for (const Bound& bound : PromBounds) {
+            for (; b < Buckets && bucketUpper(b) <= bound.ns; ++b) cumulative += t->counts[a][b];
+            out << "oop_request_duration_seconds_bucket" << label(a) << ",le=\"" << bound.le << "\"} "
+                << cumulative << '\n';
+        }
+        for (; b < Buckets; ++b) cumulative += t->counts[a][b];
+        out << "oop_request_duration_seconds_bucket" << label(a) << ",le=\"+Inf\"} " << cumulative << '\n';
+        out << "oop_request_duration_seconds_sum" << label(a) << "} " << t->sumNs[a] / 1e9 << '\n';
+        out << "oop_request_duration_seconds_count" << label(a) << "} " << cumulative << '\n';
+    }
+
+    header("oop_request_duration_quantile_seconds", "gauge",
+           "Latency quantiles from the full-resolution histogram, by action.");
+    for (int a = 0; a < ActionCount; ++a) {
+        if (!t->count[a]) continue;
+        for (double q : { 0.5, 0.9, 0.99, 0.999 })
+            out << "oop_request_duration_quantile_seconds" << label(a) << ",quantile=\"" << q << "\"} "
+                << quantileNs(*t, a, q) / 1e9 << '\n';
+    }
+
+    header("oop_bytes_received_total", "counter", "Request bytes read, including newlines.");
+    out << "oop_bytes_received_total " << t->bytesIn << '\n';
+    header("oop_bytes_sent_total", "counter", "Response bytes written, including newlines.");
+    out << "oop_bytes_sent_total " << t->bytesOut << '\n';
+    header("oop_ticks_total", "counter", "Game ticks advanced; undo and reset do not decrease it.");
+    out << "oop_ticks_total " << ticks_.load(std::memory_order_relaxed) << '\n';
+    header("oop_tick", "gauge", "Current tick of the loaded level.");
+    out << "oop_tick " << tick_.load(std::memory_order_relaxed) << '\n';
+    header("oop_robots_alive", "gauge", "Robots alive on the loaded level, placed ones included.");
+    out << "oop_robots_alive " << robots_.load(std::memory_order_relaxed) << '\n';
+    header("oop_uptime_seconds", "gauge", "Seconds since the backend started.");
+    out << "oop_uptime_seconds " << uptime << '\n';
+    return out.str();
+}
+
+bool Metrics::writeFile(const std::string& path) const {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) return false;
+        f << toPrometheus();
+        if (!f) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) std::remove(tmp.c_str());
+    return !ec;
+}
+
+bool Metrics::startFileDump(const std::string& path, int intervalMs) {
+    stopFileDump();
+    if (!writeFile(path)) return false;
+
+    dumpPath_ = path;
+    stopping_ = false;
+    dumper_ = std::thread([this, intervalMs] {
+        std::unique_lock<std::mutex> lock(dumpMutex_);
+        auto period = std::chrono::milliseconds(std::max(1, intervalMs));
+        while (!dumpWake_.wait_for(lock, period, [this] { return stopping_; }))
+            writeFile(dumpPath_);
+    });
+    return true;
+}
+
+void Metrics::stopFileDump() {
+    if (!dumper_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex_);
+        stopping_ = true;
+    }
+    dumpWake_.notify_all();
+    dumper_.join();
+    writeFile(dumpPath_);
+}
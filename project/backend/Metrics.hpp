@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+class GameEngine;
+
+// Лічильники запитів і гістограми затримок за діями. Кожен потік пише лише
+// у свій шард (лінивий, через thread_local), тож запис — кілька relaxed
+// операцій без блокувань; читачі (дія metrics, потік скидання у файл)
+// підсумовують шарди. Гістограма в стилі HDR: 16 підкошиків на кожен
+// степінь двійки, відносна похибка до 1/16, від 1 нс до ~4.9 год.
+class Metrics {
+public:
+    static constexpr int SubBits = 4;
+    static constexpr int SubBuckets = 1 << SubBits;
+    static constexpr int MaxBits = 44;
+    static constexpr int Buckets = (MaxBits - SubBits + 1) * SubBuckets;
+
+    // дії RequestHandler; невідомі й нерозібрані запити йдуть в Other
+    static constexpr std::array<std::string_view, 21> ActionNames = {
+        "load_level", "reset", "reset_keep_placements", "undo", "rewind", "status",
+        "solve", "evaluate_placements", "ray_query", "path", "flow_steer", "plan_paths",
+        "add_robot", "step", "place_robot", "spawn_robot", "edit_placement",
+        "run_step", "run_until_finished", "run", "metrics"
+    };
+    static constexpr int Other = (int)ActionNames.size();
+    static constexpr int ActionCount = Other + 1;
+
+    static int actionIndex(std::string_view action);
+    static const char* actionName(int index);
+
+    static int bucketOf(uint64_t ns);
+    static uint64_t bucketUpper(int bucket);     // найбільше значення в кошику
+
+    Metrics();
+    ~Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    void record(int action, uint64_t latencyNs, size_t bytesIn, size_t bytesOut, bool error);
+
+    // хід і кількість роботів після запиту; ticks_total росте лише вперед,
+    // тож reset і undo його не зменшують. Викликає лише потік запитів.
+    void observeEngine(const GameEngine& eng);
+
+    nlohmann::json toJson() const;
+    std::string toPrometheus() const;
+
+    // текстовий формат Prometheus: спершу path.tmp, потім перейменування,
+    // тож збирач ніколи не бачить половину файлу
+    bool writeFile(const std::string& path) const;
+
+    // фоновий потік, що переписує файл кожні intervalMs; stopFileDump
+    // (і деструктор) пише його востаннє
+    bool startFileDump(const std::string& path, int intervalMs);
+    void stopFileDump();
+
+private:
+    struct Histogram {
+        std::array<std::atomic<uint64_t>, Buckets> counts{};
+        std::atomic<uint64_t> count{0}, sumNs{0}, maxNs{0}, errors{0};
+    };
+    struct Shard {
+        std::array<Histogram, ActionCount> actions;
+        std::atomic<uint64_t> bytesIn{0}, bytesOut{0};
+    };
+    // сума шардів на момент читання
+    struct Totals {
+        std::array<std::array<uint64_t, Buckets>, ActionCount> counts{};
+        std::array<uint64_t, ActionCount> count{}, sumNs{}, maxNs{}, errors{};
+        uint64_t bytesIn = 0, bytesOut = 0;
+    };
+
+    Shard& shard();
+    std::unique_ptr<Totals> collect() const;
+    static double quantileNs(const Totals& t, int action, double q);
+
+    const std::chrono::steady_clock::time_point started_;
+    const uint64_t id_;
+
+    mutable std::mutex shardsMutex_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::atomic<uint64_t> ticks_{0}, tick_{0}, robots_{0};
+    int lastMoves_ = 0;
+
+    std::mutex dumpMutex_;
+    std::condition_variable dumpWake_;
+    std::thread dumper_;
+    std::string dumpPath_;
+    bool stopping_ = false;
+};
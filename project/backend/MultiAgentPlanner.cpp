@@ -0,0 +1,290 @@
+#include "MultiAgentPlanner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <queue>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+using json = nlohmann::json;
+
+static const char* dirName(Direction d) {
+    switch (d) {
+        case Direction::Up: return "up";
+        case Direction::Down: return "down";
+        case Direction::Left: return "left";
+        case Direction::Right: return "right";
+    }
+    return "up";
+}
+
+// Хто де стоїть у який тік, по клітинках: одна клітинка — один пошук у
+// хеші й короткий відсортований список. Вікно ±1 тік робить однаковими
+// для перевірки і зустріч, і обмін, і вхід слідом.
+struct MultiAgentPlanner::Reservations {
+    struct Cell {
+        int holdFrom = INT_MAX;                    // з цього тіку зайнята назавжди
+        std::vector<std::pair<int,int>> times;     // (тік, власник) за зростанням тіку
+    };
+    std::unordered_map<int, Cell> cells;
+
+    bool blocked(int cell, int t, int self) const {
+        auto it = cells.find(cell);
+        if (it == cells.end()) return false;
+        if (it->second.holdFrom <= t + 1) return true;
+
+        auto& v = it->second.times;
+        auto r = std::lower_bound(v.begin(), v.end(), std::make_pair(t - 1, INT_MIN));
+        for (; r != v.end() && r->first <= t + 1; ++r)
+            if (r->second != self) return true;
+        return false;
+    }
+
+    // останній тік, коли клітинку займає хтось інший
+    int busyUntil(int cell, int self) const {
+        auto it = cells.find(cell);
+        if (it == cells.end()) return -1;
+        auto& v = it->second.times;
+        for (auto r = v.rbegin(); r != v.rend(); ++r)
+            if (r->second != self) return r->first;
+        return -1;
+    }
+
+    void add(int cell, int t, int self) {
+        auto& v = cells[cell].times;
+        auto pos = std::upper_bound(v.begin(), v.end(), std::make_pair(t, INT_MAX));
+        v.insert(pos, { t, self });
+    }
+
+    // після останнього тіку шлях лишається у своїй кінцевій клітинці
+    void reserve(const std::vector<int>& path, int self) {
+        for (size_t t = 1; t < path.size(); ++t) add(path[t], (int)t, self);
+        cells[path.back()].holdFrom = (int)path.size() - 1;
+    }
+};
+
+MultiAgentPlanner::MultiAgentPlanner(const GameEngine& eng, PathService& paths, PlanOptions opt)
+    : eng_(eng), paths_(paths), opt_(opt) {}
+
+int MultiAgentPlanner::heuristic(const Agent& a, int cell) const {
+    if (a.dist) return (*a.dist)[cell];
+    return std::abs(cell % width_ - a.goal % width_) + std::abs(cell / width_ - a.goal / width_);
+}
+
+std::vector<int> MultiAgentPlanner::spaceTimeSearch(const Agent& a, const Reservations& res) const {
+    const Level& lvl = eng_.getLevel();
+    const int self = a.robotId;   // власник резервацій — id робота
+    const uint64_t cells = (uint64_t)width_ * height_;
+
+    struct Open { int f, t, cell; };
+    auto worse = [](const Open& x, const Open& y) {
+        return x.f != y.f ? x.f > y.f : x.t < y.t;
+    };
+    std::priority_queue<Open, std::vector<Open>, decltype(worse)> open(worse);
+    std::unordered_map<uint64_t, int> parent;  // (t, клітинка) → клітинка на t - 1
+    parent.reserve(1024);
+
+    if (res.blocked(a.start, 0, self)) return {};
+    parent[a.start] = -1;
+    open.push({ heuristic(a, a.start), 0, a.start });
+
+    const int dx[5] = { 0, 0, 0, -1, 1 };
+    const int dy[5] = { 0, -1, 1, 0, 0 };
+
+    while (!open.empty()) {
+        Open cur = open.top();
+        open.pop();
+
+        // у цілі можна лишитись, лише коли ніхто пізніше крізь неї не піде
+        if (cur.cell == a.goal && res.busyUntil(a.goal, self) < cur.t - 1) {
+            std::vector<int> path(cur.t + 1);
+            int cell = cur.cell;
+            for (int t = cur.t; t >= 0; --t) {
+                path[t] = cell;
+                cell = parent[(uint64_t)t * cells + cell];
+            }
+            return path;
+        }
+        if (cur.t >= opt_.maxTicks) continue;
+
+        const int x = cur.cell % width_, y = cur.cell / width_;
+        const int t = cur.t + 1;
+        for (int k = 0; k < 5; ++k) {
+            int nx = x + dx[k], ny = y + dy[k];
+            if (!lvl.isInside(nx, ny) || lvl.isWall(nx, ny)) continue;
+            int next = ny * width_ + nx;
+            if (res.blocked(next, t, self)) continue;
+            if (!parent.emplace((uint64_t)t * cells + next, cur.cell).second) continue;
+            open.push({ t + heuristic(a, next), t, next });
+        }
+    }
+    return {};
+}
+
+bool MultiAgentPlanner::planOrdering(const std::vector<Agent>& agents, const std::vector<int>& order,
+                                     std::vector<std::vector<int>>& out) const
+{
+    Reservations res;
+    for (int cell : obstacles_) res.cells[cell].holdFrom = 0;
+    // старти ще не спланованих роботів зайняті хоча б у тік 0
+    for (auto& a : agents) res.add(a.start, 0, a.robotId);
+
+    out.assign(agents.size(), {});
+    for (int i : order) {
+        out[i] = spaceTimeSearch(agents[i], res);
+        if (out[i].empty()) return false;
+        res.reserve(out[i], agents[i].robotId);
+    }
+    return true;
+}
+
+PlanResult MultiAgentPlanner::plan(const std::vector<PlanGoal>& goals) {
+    using Clock = std::chrono::steady_clock;
+    const auto started = Clock::now();
+
+    const Level& lvl = eng_.getLevel();
+    width_ = lvl.getWidth();
+    height_ = lvl.getHeight();
+
+    PlanResult result;
+    auto finish = [&]() {
+        result.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+        return result;
+    };
+
+    std::vector<Agent> agents;
+    size_t fieldBytes = 0;
+    for (auto& g : goals) {
+        const RobotState* st = nullptr;
+        for (auto* arr : { &lvl.getRobots(), &lvl.getPlacedRobots() })
+            for (auto& r : *arr)
+                if (r->getState() && r->getState()->id == g.robotId) st = r->getState();
+        if (!st || !st->alive) return finish();
+
+        Agent a{ g.robotId, st->y * width_ + st->x, g.y * width_ + g.x, nullptr };
+        if (lvl.componentAt(st->x, st->y) != lvl.componentAt(g.x, g.y)) return finish();
+
+        // сервіс не потокобезпечний і може витіснити поле — беремо копію
+        const size_t bytes = (size_t)width_ * height_ * sizeof(int32_t);
+        if (fieldBytes + bytes <= opt_.heuristicBytes) {
+            a.dist = std::make_shared<const std::vector<int32_t>>(paths_.field(lvl, g.x, g.y));
+            fieldBytes += bytes;
+        }
+        agents.push_back(a);
+    }
+
+    obstacles_.clear();
+    auto collect = [&](const std::vector<std::unique_ptr<Robot>>& arr) {
+        for (auto& r : arr) {
+            auto* st = r->getState();
+            if (!st || !st->alive || !lvl.isInside(st->x, st->y)) continue;
+            bool planned = std::any_of(goals.begin(), goals.end(),
+                                       [&](const PlanGoal& g) { return g.robotId == st->id; });
+            if (!planned) obstacles_.push_back(st->y * width_ + st->x);
+        }
+    };
+    collect(lvl.getRobots());
+    collect(lvl.getPlacedRobots());
+
+    // ціль під нерухомим роботом недосяжна за будь-якого порядку
+    for (auto& a : agents)
+        if (std::find(obstacles_.begin(), obstacles_.end(), a.goal) != obstacles_.end()) return finish();
+
+    int threads = opt_.threads > 0 ? opt_.threads : (int)std::thread::hardware_concurrency();
+    threads = std::max(1, threads);
+    const int orderings = opt_.orderings > 0 ? opt_.orderings : std::max(4, threads);
+    threads = std::min(threads, orderings);
+
+    // 0 — спершу найдальші, 1 — спершу найближчі, далі — випадкові
+    std::vector<std::vector<int>> orders(orderings);
+    std::vector<int> byDistance(agents.size());
+    for (size_t i = 0; i < agents.size(); ++i) byDistance[i] = (int)i;
+    std::stable_sort(byDistance.begin(), byDistance.end(), [&](int a, int b) {
+        return heuristic(agents[a], agents[a].start) > heuristic(agents[b], agents[b].start);
+    });
+    for (int k = 0; k < orderings; ++k) {
+        orders[k] = byDistance;
+        if (k == 1) std::reverse(orders[k].begin(), orders[k].end());
+        if (k >= 2) std::shuffle(orders[k].begin(), orders[k].end(), std::mt19937(opt_.seed + k));
+    }
+
+    std::vector<std::vector<std::vector<int>>> plans(orderings);
+    std::vector<char> ok(orderings, 0);
+    std::atomic<int> next{0};
+
+    auto worker = [&]() {
+        for (int k = next++; k < orderings; k = next++)
+            ok[k] = planOrdering(agents, orders[k], plans[k]);
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    result.orderingsTried = orderings;
+    long bestCost = LONG_MAX;
+    for (int k = 0; k < orderings; ++k) {
+        if (!ok[k]) continue;
+        long cost = 0;
+        for (auto& p : plans[k]) cost += (long)p.size() - 1;
+        if (cost < bestCost) {
+            bestCost = cost;
+            result.ordering = k;
+        }
+    }
+    if (result.ordering < 0) return finish();
+
+    const auto& best = plans[result.ordering];
+    result.solved = true;
+    result.sumOfCosts = bestCost;
+    for (auto& p : best) result.makespan = std::max(result.makespan, (int)p.size() - 1);
+
+    result.ticks.assign(result.makespan, {});
+    for (size_t i = 0; i < best.size(); ++i) {
+        auto& cells = result.paths.emplace_back();
+        for (int c : best[i]) cells.emplace_back(c % width_, c / width_);
+
+        for (size_t t = 0; t + 1 < best[i].size(); ++t) {
+            int from = best[i][t], to = best[i][t + 1];
+            if (from == to) continue;
+            Direction d = to == from - width_ ? Direction::Up
+                        : to == from + width_ ? Direction::Down
+                        : to == from - 1 ? Direction::Left
+                        : Direction::Right;
+            result.ticks[t].push_back(Command{ agents[i].robotId, CommandType::Move, d });
+        }
+    }
+    return finish();
+}
+
+json MultiAgentPlanner::resultToJson(const PlanResult& r) {
+    json ticks = json::array();
+    for (auto& tick : r.ticks) {
+        json cmds = json::array();
+        for (auto& c : tick) cmds.push_back({{"robot_id", c.robotId}, {"cmd", "move"}, {"dir", dirName(c.dir)}});
+        ticks.push_back(cmds);
+    }
+
+    json paths = json::array();
+    for (auto& p : r.paths) {
+        json cells = json::array();
+        for (auto& c : p) cells.push_back({ c.first, c.second });
+        paths.push_back(cells);
+    }
+
+    return json{
+        {"solved", r.solved},
+        {"makespan", r.makespan},
+        {"sum_of_costs", r.sumOfCosts},
+        {"ordering", r.ordering},
+        {"orderings_tried", r.orderingsTried},
+        {"ticks", ticks},
+        {"paths", paths},
+        {"elapsed_ms", r.elapsedMs}
+    };
+}
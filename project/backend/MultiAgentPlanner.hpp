@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "GameEngine.hpp"
+#include "PathService.hpp"
+
+// Куди має дійти один робітник
+struct PlanGoal {
+    int robotId = 0;
+    int x = 0;
+    int y = 0;
+};
+
+struct PlanOptions {
+    int maxTicks = 1000;              // горизонт плану
+    int threads = 0;                  // 0 — усі ядра
+    int orderings = 0;                // скільки порядків пріоритетів пробувати; 0 — по одному на потік, не менше 4
+    unsigned seed = 1;
+    size_t heuristicBytes = 256ull << 20;   // поля відстаней до цілей; решта цілей — манхеттен
+};
+
+struct PlanResult {
+    bool solved = false;
+    int makespan = 0;                 // тіків до останнього прибуття
+    long sumOfCosts = 0;              // сума часів прибуття
+    int ordering = -1;                // номер порядку, що дав план
+    int orderingsTried = 0;
+    // ticks[t] — команди для applyCommands на тіку t; стоїть — без команди
+    std::vector<std::vector<Command>> ticks;
+    // шлях кожного робота з goals по тіках: paths[i][t] — клітинка в момент t
+    std::vector<std::vector<std::pair<int,int>>> paths;
+    double elapsedMs = 0;
+};
+
+// Пріоритетне планування з таблицею резервацій. Роботи плануються по
+// одному A* у просторі-часі в обхід клітинок, уже зайнятих тими, кого
+// сплановано раніше. Клітинку не можна займати, якщо інший робот стоїть у
+// ній тіком раніше, тоді чи тіком пізніше: так не буває ні зустрічі, ні
+// обміну місцями, ні входу слідом за роботом, що якраз виходить, — у
+// stepAuto кожен із цих випадків убив би когось залежно від порядку ходу,
+// а тут план безпечний за будь-якого порядку команд. Роботи поза планом —
+// нерухомі перешкоди. Порядки пріоритетів (за довжиною шляху і випадкові)
+// пробуються паралельно; з успішних береться найменша сума часів, за
+// рівності — менший номер порядку, тож результат не залежить від потоків.
+class MultiAgentPlanner {
+public:
+    MultiAgentPlanner(const GameEngine& eng, PathService& paths, PlanOptions opt = {});
+
+    PlanResult plan(const std::vector<PlanGoal>& goals);
+
+    static nlohmann::json resultToJson(const PlanResult& r);
+
+private:
+    struct Agent {
+        int robotId;
+        int start;                    // y*W + x
+        int goal;
+        std::shared_ptr<const std::vector<int32_t>> dist;   // до goal; nullptr — манхеттен
+    };
+
+    struct Reservations;
+
+    const GameEngine& eng_;
+    PathService& paths_;
+    PlanOptions opt_;
+    int width_ = 0, height_ = 0;
+    std::vector<int> obstacles_;      // клітинки роботів поза планом
+
+    int heuristic(const Agent& a, int cell) const;
+    // шлях по тіках або порожній, якщо в межах горизонту його немає
+    std::vector<int> spaceTimeSearch(const Agent& a, const Reservations& res) const;
+    // усі агенти в порядку order; false — хтось не знайшов шляху
+    bool planOrdering(const std::vector<Agent>& agents, const std::vector<int>& order,
+                      std::vector<std::vector<int>>& out) const;
+};
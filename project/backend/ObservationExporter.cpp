@@ -0,0 +1,195 @@
+#include "ObservationExporter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t sessions;
+    uint32_t channels;
+    uint32_t width;
+    uint32_t height;
+    uint64_t frameBytes;
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> writing;
+    uint64_t dataOffset;
+    uint64_t reserved;
+};
+static_assert(sizeof(Header) == 64, "header layout is part of the protocol");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "counters are shared between processes");
+
+}
+
+ObservationExporter::~ObservationExporter() {
+    close();
+}
+
+bool ObservationExporter::open(const std::string& name) {
+    close();
+
+#ifdef _WIN32
+    (void)name;
+    return false;
+#else
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) return false;
+    if (ftruncate(fd, sizeof(Header)) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* p = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    fd_ = fd;
+    name_ = name;
+    base_ = static_cast<unsigned char*>(p);
+    mapped_ = sizeof(Header);
+    seq_ = 0;
+    sessions_ = width_ = height_ = 0;
+
+    Header* h = new (base_) Header{};
+    std::memcpy(h->magic, "OOPO", 4);
+    h->version = 1;
+    h->channels = ObsChannelCount;
+    h->dataOffset = sizeof(Header);
+    return true;
+#endif
+}
+
+void ObservationExporter::close() {
+    if (!base_) return;
+
+#ifndef _WIN32
+    munmap(base_, mapped_);
+    ::close(fd_);
+    shm_unlink(name_.c_str());
+    fd_ = -1;
+#endif
+    base_ = nullptr;
+    mapped_ = 0;
+}
+
+bool ObservationExporter::shape(int sessions, int width, int height) {
+    if (sessions == sessions_ && width == width_ && height == height_) return true;
+
+#ifdef _WIN32
+    return false;
+#else
+    const uint64_t frame = (uint64_t)sessions * ObsChannelCount * width * height;
+    const size_t needed = sizeof(Header) + 2 * frame;
+    Header* h = reinterpret_cast<Header*>(base_);
+
+    // обидва слоти стають недійсними: наступний кадр — через номер
+    h->writing.store(seq_ + 2, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    ++seq_;
+
+    if (needed > mapped_) {
+        if (ftruncate(fd_, (off_t)needed) != 0) return false;
+        void* p = mmap(nullptr, needed, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) return false;
+        munmap(base_, mapped_);
+        base_ = static_cast<unsigned char*>(p);
+        mapped_ = needed;
+        h = reinterpret_cast<Header*>(base_);
+    }
+
+    h->sessions = (uint32_t)sessions;
+    h->width = (uint32_t)width;
+    h->height = (uint32_t)height;
+    h->frameBytes = frame;
+    sessions_ = sessions;
+    width_ = width;
+    height_ = height;
+    return true;
+#endif
+}
+
+unsigned char* ObservationExporter::beginFrame() {
+    Header* h = reinterpret_cast<Header*>(base_);
+    const uint64_t k = seq_ + 1;
+    h->writing.store(k, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return base_ + sizeof(Header) + (k % 2) * h->frameBytes;
+}
+
+void ObservationExporter::endFrame() {
+    Header* h = reinterpret_cast<Header*>(base_);
+    ++seq_;
+    h->seq.store(seq_, std::memory_order_release);
+}
+
+bool ObservationExporter::publish(const std::vector<const GameEngine*>& sessions) {
+    if (!base_) return false;
+
+    int width = 0, height = 0;
+    for (auto* eng : sessions) {
+        width = std::max(width, eng->getLevel().getWidth());
+        height = std::max(height, eng->getLevel().getHeight());
+    }
+    if (!shape((int)sessions.size(), width, height)) return false;
+
+    unsigned char* out = beginFrame();
+    const size_t planes = (size_t)ObsChannelCount * width * height;
+    for (size_t i = 0; i < sessions.size(); ++i)
+        writePlanes(*sessions[i], out + i * planes, width, height);
+    endFrame();
+    return true;
+}
+
+bool ObservationExporter::publish(const VecEnv& env) {
+    if (!base_ || !shape(env.size(), env.width(), env.height())) return false;
+
+    unsigned char* out = beginFrame();
+    std::memcpy(out, env.observations().data(), env.observations().size());
+    endFrame();
+    return true;
+}
+
+void ObservationExporter::writePlanes(const GameEngine& eng, uint8_t* out, int width, int height) {
+    const Level& lvl = eng.getLevel();
+    const size_t plane = (size_t)width * height;
+    std::memset(out, 0, ObsChannelCount * plane);
+
+    const int w = std::min(width, lvl.getWidth()), h = std::min(height, lvl.getHeight());
+    auto at = [&](int ch, int x, int y) -> uint8_t& { return out[ch * plane + (size_t)y * width + x]; };
+    auto inside = [&](int x, int y) { return x >= 0 && y >= 0 && x < w && y < h; };
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            at(ObsWalls, x, y) = lvl.isWall(x, y);
+            at(ObsTargets, x, y) = lvl.isTarget(x, y);
+        }
+    }
+
+    for (auto& b : lvl.getBoxes())
+        if (!b.delivered && inside(b.x, b.y)) at(ObsBoxes, b.x, b.y) = 1;
+
+    auto robots = [&](const std::vector<std::unique_ptr<Robot>>& arr) {
+        for (auto& r : arr) {
+            auto* s = r->getState();
+            if (!s || !s->alive || !inside(s->x, s->y)) continue;
+            int ch = s->type == RobotType::Worker ? ObsWorkerUp + (int)s->dir : ObsControllers;
+            at(ch, s->x, s->y) = 1;
+        }
+    };
+    robots(lvl.getRobots());
+    robots(lvl.getPlacedRobots());
+}
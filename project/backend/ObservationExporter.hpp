@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GameEngine.hpp"
+#include "VecEnv.hpp"
+
+// Площини спостереження (див. ObsChannel) для однієї чи багатьох сесій у
+// POSIX shared memory, щоб читач відображав їх у numpy без копіювання.
+//
+// Розкладка області (little-endian):
+//   0  char[4]  "OOPO"          4  u32 версія (1)
+//   8  u32 сесій               12  u32 площин
+//   16 u32 ширина              20  u32 висота
+//   24 u64 байтів у кадрі       32  u64 seq — останній готовий кадр, 0 — ще немає
+//   40 u64 writing — кадр, що пишеться   48  u64 зсув даних (64)
+//   далі два слоти по кадру: кадр k — у слоті k % 2, [сесія][площина][y][x]
+//
+// Поки пишеться кадр k, слот кадру k - 1 не чіпається. Читач бере s = seq,
+// дивиться в слот s % 2 і після використання перевіряє writing < s + 2:
+// інакше слот уже переписувався і кадр треба взяти наново. Зміна розміру
+// карти чи кількості сесій перескакує номер кадру, тож і вона видна так само;
+// область лише росте, тож старе відображення лишається дійсним за розміром.
+// На Windows open повертає false.
+class ObservationExporter {
+public:
+    ObservationExporter() = default;
+    ~ObservationExporter();
+
+    ObservationExporter(const ObservationExporter&) = delete;
+    ObservationExporter& operator=(const ObservationExporter&) = delete;
+
+    // name — ім'я для shm_open ("/oop_obs"); область прибирається в close
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return base_ != nullptr; }
+
+    // новий кадр; сесії з меншою картою доповнюються нулями
+    bool publish(const std::vector<const GameEngine*>& sessions);
+    bool publish(const VecEnv& env);
+
+    uint64_t sequence() const { return seq_; }
+
+    // площини однієї сесії в out: ObsChannelCount × height × width
+    static void writePlanes(const GameEngine& eng, uint8_t* out, int width, int height);
+
+private:
+    std::string name_;
+    unsigned char* base_ = nullptr;
+    size_t mapped_ = 0;
+    uint64_t seq_ = 0;
+    int sessions_ = 0, width_ = 0, height_ = 0;
+
+#ifndef _WIN32
+    int fd_ = -1;
+#endif
+
+    // кадр для сесій такого розміру; false — область не вдалося збільшити
+    bool shape(int sessions, int width, int height);
+    unsigned char* beginFrame();
+    void endFrame();
+};
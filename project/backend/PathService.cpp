@@ -0,0 +1,242 @@
+#include "PathService.hpp"
+#include <algorithm>
+
+PathService::PathService(size_t capacityBytes) : capacity_(capacityBytes) {}
+
+void PathService::setCapacity(size_t bytes) {
+    capacity_ = bytes;
+    evict();
+}
+
+void PathService::clear() {
+    lru_.clear();
+    index_.clear();
+    used_ = 0;
+    layout_ = 0;
+    wallsSeen_ = 0;
+}
+
+// Інша розкладка — кеш з нуля; ті самі, але з новими стінами — лише
+// поля, яких ці стіни торкаються
+void PathService::sync(const Level& lvl) {
+    if (lvl.layoutId() != layout_ || lvl.getWidth() != width_ || lvl.getHeight() != height_ ||
+        lvl.getWalls().size() < wallsSeen_)
+    {
+        clear();
+        layout_ = lvl.layoutId();
+        width_ = lvl.getWidth();
+        height_ = lvl.getHeight();
+        wallsSeen_ = lvl.getWalls().size();
+
+        // цілі й коробки — найчастіші кінці шляхів
+        const size_t fieldBytes = (size_t)width_ * height_ * sizeof(int32_t);
+        if (!lvl.getTargets().empty() && fieldBytes <= capacity_)
+            compute(lvl, AllTargets, true);
+        auto warm = [&](const std::vector<std::pair<int,int>>& cells) {
+            for (auto& c : cells) {
+                if (used_ + fieldBytes > capacity_) return;
+                if (!lvl.isInside(c.first, c.second) || lvl.isWall(c.first, c.second)) continue;
+                int source = c.second * width_ + c.first;
+                if (!find(source)) compute(lvl, source, true);
+            }
+        };
+        warm(lvl.getTargets());
+        std::vector<std::pair<int,int>> boxes;
+        for (auto& b : lvl.getBoxes())
+            if (!b.delivered) boxes.emplace_back(b.x, b.y);
+        warm(boxes);
+        return;
+    }
+
+    auto& walls = lvl.getWalls();
+    for (; wallsSeen_ < walls.size(); ++wallsSeen_)
+        wallAdded(walls[wallsSeen_].first, walls[wallsSeen_].second);
+}
+
+void PathService::wallAdded(int x, int y) {
+    if (x < 0 || y < 0 || x >= width_ || y >= height_) return;
+    const size_t cell = (size_t)y * width_ + x;
+
+    // стіна в недосяжній клітинці поля не змінює
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        auto next = std::next(it);
+        if (it->dist[cell] >= 0) drop(it);
+        it = next;
+    }
+}
+
+void PathService::drop(std::list<Field>::iterator it) {
+    used_ -= it->dist.size() * sizeof(int32_t) + it->flow.size();
+    index_.erase(it->source);
+    lru_.erase(it);
+}
+
+PathService::Field* PathService::find(int source) {
+    auto it = index_.find(source);
+    if (it == index_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return &*it->second;
+}
+
+PathService::Field& PathService::compute(const Level& lvl, int source, bool pinned) {
+    ++misses_;
+
+    lru_.push_front(Field{ source, pinned, std::vector<int32_t>((size_t)width_ * height_, -1), {} });
+    Field& f = lru_.front();
+    index_[source] = lru_.begin();
+    used_ += f.dist.size() * sizeof(int32_t);
+
+    const int dx[4] = { 0, 0, -1, 1 };
+    const int dy[4] = { -1, 1, 0, 0 };
+
+    queue_.clear();
+    if (source == AllTargets) {
+        for (auto& t : lvl.getTargets()) {
+            if (!lvl.isInside(t.first, t.second) || lvl.isWall(t.first, t.second)) continue;
+            int cell = t.second * width_ + t.first;
+            if (f.dist[cell] == 0) continue;
+            f.dist[cell] = 0;
+            queue_.push_back(cell);
+        }
+    } else {
+        queue_.push_back(source);
+        f.dist[source] = 0;
+    }
+
+    for (size_t head = 0; head < queue_.size(); ++head) {
+        int cur = queue_[head];
+        int x = cur % width_, y = cur / width_;
+        for (int k = 0; k < 4; ++k) {
+            int nx = x + dx[k], ny = y + dy[k];
+            if (!lvl.isInside(nx, ny) || lvl.isWall(nx, ny)) continue;
+            int ni = ny * width_ + nx;
+            if (f.dist[ni] >= 0) continue;
+            f.dist[ni] = f.dist[cur] + 1;
+            queue_.push_back(ni);
+        }
+    }
+
+    evict();
+    return f;
+}
+
+// спершу звичайні поля з хвоста, закріплені — лише якщо інакше не вміститись;
+// щойно пораховане (голова списку) лишається завжди
+void PathService::evict() {
+    if (lru_.empty()) return;
+    for (int pass = 0; pass < 2 && used_ > capacity_; ++pass) {
+        for (auto it = std::prev(lru_.end()); used_ > capacity_ && it != lru_.begin();) {
+            auto prev = std::prev(it);
+            if (pass == 1 || !it->pinned) drop(it);
+            it = prev;
+        }
+    }
+}
+
+PathService::Field& PathService::get(const Level& lvl, int source) {
+    if (Field* f = find(source)) {
+        ++hits_;
+        return *f;
+    }
+    return compute(lvl, source, false);
+}
+
+const std::vector<int32_t>& PathService::field(const Level& lvl, int x, int y) {
+    sync(lvl);
+    return get(lvl, y * width_ + x).dist;
+}
+
+// Крок до сусіда з відстанню на одиницю меншою; порядок сусідів —
+// як у Direction, тож рівні варіанти розв'язуються так само, як у path()
+const std::vector<uint8_t>& PathService::flowOf(Field& f) {
+    if (!f.flow.empty()) return f.flow;
+
+    f.flow.assign(f.dist.size(), NoFlow);
+    used_ += f.flow.size();
+
+    const int32_t* d = f.dist.data();
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            const size_t i = (size_t)y * width_ + x;
+            const int32_t want = d[i] - 1;
+            if (want < 0) continue;
+            if (y > 0 && d[i - width_] == want) f.flow[i] = (uint8_t)Direction::Up;
+            else if (y + 1 < height_ && d[i + width_] == want) f.flow[i] = (uint8_t)Direction::Down;
+            else if (x > 0 && d[i - 1] == want) f.flow[i] = (uint8_t)Direction::Left;
+            else f.flow[i] = (uint8_t)Direction::Right;
+        }
+    }
+
+    evict();
+    return f.flow;
+}
+
+const std::vector<uint8_t>& PathService::flow(const Level& lvl, int x, int y) {
+    sync(lvl);
+    return flowOf(get(lvl, y * width_ + x));
+}
+
+const std::vector<uint8_t>& PathService::flowToTargets(const Level& lvl) {
+    sync(lvl);
+    return flowOf(get(lvl, AllTargets));
+}
+
+void PathService::steer(const std::vector<uint8_t>& flow, const std::vector<int32_t>& cells,
+                        std::vector<uint8_t>& out)
+{
+    out.resize(cells.size());
+    const uint8_t* f = flow.data();
+    const size_t n = flow.size();
+    for (size_t i = 0; i < cells.size(); ++i)
+        out[i] = (size_t)cells[i] < n ? f[cells[i]] : NoFlow;
+}
+
+int PathService::distance(const Level& lvl, int sx, int sy, int tx, int ty) {
+    if (!lvl.isInside(sx, sy) || !lvl.isInside(tx, ty) || lvl.isWall(sx, sy) || lvl.isWall(tx, ty))
+        return -1;
+    if (lvl.componentAt(sx, sy) != lvl.componentAt(tx, ty))
+        return -1;
+
+    // відстань симетрична: годиться поле від будь-якого кінця
+    sync(lvl);
+    if (const Field* f = find(sy * width_ + sx)) {
+        ++hits_;
+        return f->dist[(size_t)ty * width_ + tx];
+    }
+    return field(lvl, tx, ty)[(size_t)sy * width_ + sx];
+}
+
+std::vector<std::pair<int,int>> PathService::path(const Level& lvl, int sx, int sy, int tx, int ty) {
+    std::vector<std::pair<int,int>> cells;
+    if (distance(lvl, sx, sy, tx, ty) < 0) return cells;
+
+    // спуск за полем від (tx, ty); якщо закешоване лише поле від (sx, sy) —
+    // спуск від цілі до старту і розворот
+    bool reversed = false;
+    const Field* f = find(ty * width_ + tx);
+    if (!f) {
+        f = find(sy * width_ + sx);
+        reversed = true;
+    }
+    if (reversed) std::swap(sx, tx), std::swap(sy, ty);
+
+    const int dx[4] = { 0, 0, -1, 1 };
+    const int dy[4] = { -1, 1, 0, 0 };
+
+    int x = sx, y = sy;
+    cells.emplace_back(x, y);
+    while (x != tx || y != ty) {
+        int d = f->dist[(size_t)y * width_ + x];
+        for (int k = 0; k < 4; ++k) {
+            int nx = x + dx[k], ny = y + dy[k];
+            if (!lvl.isInside(nx, ny) || f->dist[(size_t)ny * width_ + nx] != d - 1) continue;
+            x = nx;
+            y = ny;
+            break;
+        }
+        cells.emplace_back(x, y);
+    }
+
+    if (reversed) std::reverse(cells.begin(), cells.end());
+    return cells;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Level.hpp"
+
+// Найкоротші шляхи по рельєфу рівня (4-зв'язність, стіни непрохідні).
+// Відповідь дає поле відстаней BFS від однієї з кінцевих клітинок: поля від
+// цілей і коробок рахуються наперед, решта — за потреби і витісняються
+// за LRU. Поле прив'язане до розкладки рівня (Level::layoutId); нова стіна
+// скидає лише ті поля, з джерела яких її клітинка була досяжна.
+// Не потокобезпечний: один сервіс на обробник запитів.
+class PathService {
+public:
+    explicit PathService(size_t capacityBytes = 64ull << 20);
+
+    // довжина найкоротшого шляху; -1 — недосяжно або клітинка поза картою/у стіні
+    int distance(const Level& lvl, int sx, int sy, int tx, int ty);
+
+    // клітинки шляху від (sx, sy) до (tx, ty) включно; порожній — недосяжно
+    std::vector<std::pair<int,int>> path(const Level& lvl, int sx, int sy, int tx, int ty);
+
+    // поле відстаней від (x, y): y*W + x → кроків, -1 — недосяжно
+    const std::vector<int32_t>& field(const Level& lvl, int x, int y);
+
+    // Поле напрямків до (x, y): y*W + x → перший крок найкоротшого шляху
+    // (значення Direction), NoFlow — клітинка недосяжна, у стіні або сама ціль.
+    // Будується з поля відстаней і скидається разом з ним.
+    static constexpr uint8_t NoFlow = 0xFF;
+    const std::vector<uint8_t>& flow(const Level& lvl, int x, int y);
+    // те саме до найближчої з цілей рівня
+    const std::vector<uint8_t>& flowToTargets(const Level& lvl);
+
+    // напрямок для кожної клітинки cells (y*W + x) одним проходом по полю;
+    // клітинки поза картою отримують NoFlow
+    static void steer(const std::vector<uint8_t>& flow, const std::vector<int32_t>& cells,
+                      std::vector<uint8_t>& out);
+
+    void setCapacity(size_t bytes);
+    size_t fields() const { return lru_.size(); }
+    size_t bytesUsed() const { return used_; }
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+    void clear();
+
+private:
+    struct Field {
+        int source;                  // y*W + x; AllTargets — від усіх цілей
+        bool pinned;                 // ціль або коробка — не витісняється
+        std::vector<int32_t> dist;
+        std::vector<uint8_t> flow;   // порожнє, доки не попросили
+    };
+
+    static constexpr int AllTargets = -1;
+
+    size_t capacity_;
+    size_t used_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+
+    uint64_t layout_ = 0;
+    size_t wallsSeen_ = 0;
+    int width_ = 0, height_ = 0;
+
+    std::list<Field> lru_;   // спереду — найсвіжіші
+    std::unordered_map<int, std::list<Field>::iterator> index_;
+    std::vector<int> queue_;
+
+    void sync(const Level& lvl);
+    void wallAdded(int x, int y);
+    Field& compute(const Level& lvl, int source, bool pinned);
+    Field* find(int source);
+    Field& get(const Level& lvl, int source);
+    const std::vector<uint8_t>& flowOf(Field& f);
+    void drop(std::list<Field>::iterator it);
+    void evict();
+};
@@ -0,0 +1,379 @@
+#include "PlacementSolver.hpp"
+#include "WorkerRobot.hpp"
+#include "ControllerRobot.hpp"
+#include "BitboardEngine.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+using json = nlohmann::json;
+
+static const char* dirName(Direction d) {
+    switch (d) {
+        case Direction::Up: return "up";
+        case Direction::Down: return "down";
+        case Direction::Left: return "left";
+        case Direction::Right: return "right";
+    }
+    return "up";
+}
+
+static Direction dirFromName(const std::string& s) {
+    if (s == "down") return Direction::Down;
+    if (s == "left") return Direction::Left;
+    if (s == "right") return Direction::Right;
+    return Direction::Up;
+}
+
+PlacementSolver::PlacementSolver(const GameEngine& base, SolveOptions opt)
+    : base_(base), opt_(opt) {}
+
+std::unique_ptr<Robot> PlacementSolver::makeRobot(const Placement& p) {
+    std::unique_ptr<Robot> r;
+
+    if (p.type == RobotType::Worker) {
+        r = std::make_unique<WorkerRobot>();
+    } else {
+        auto c = std::make_unique<ControllerRobot>();
+        Command C{};
+        C.type = p.command;
+        C.dir = p.dir;
+        c->setCommand(C);
+        r = std::move(c);
+    }
+
+    r->setPosition(p.x, p.y);
+    r->setDirection(p.dir);
+    return r;
+}
+
+// стани, пройдені прогоном; після завершення всі потрапляють у таблицю
+struct Visit { uint64_t hash; int tick; };
+
+// Прогін до кінця з таблицею результатів на рушії eng (GameEngine або
+// BitboardEngine); false — рушій не зміг зробити ходу, прогін не завершено
+template<class Engine>
+static bool runWithTable(Engine& eng, int maxTicks, GameEngine::RunResult& res,
+                         TranspositionTable* tt, uint64_t* ttHits, std::vector<Visit>& path)
+{
+    bool known = false;
+
+    while (res.ticks < maxTicks && !eng.isFinished()) {
+        if (tt && eng.isRunning()) {
+            TranspositionTable::Entry e;
+            if (tt->probe(eng.getStateHash(), e) && res.ticks + (int)e.ticksLeft <= maxTicks) {
+                if (ttHits) ++*ttHits;
+                res.ticks += (int)e.ticksLeft;
+                res.win = e.outcome == TranspositionTable::Win;
+                res.lose = !res.win;
+                known = true;
+                break;
+            }
+            path.push_back({ eng.getStateHash(), res.ticks });
+        }
+        int k = eng.advance(maxTicks - res.ticks);
+        if (k == 0) return false;
+        res.ticks += k;
+    }
+
+    if (!known) {
+        res.win = eng.isWin();
+        res.lose = eng.isLose();
+        res.nonTerminating = eng.isNonTerminating();
+    }
+
+    if (tt && (known || eng.isFinished())) {
+        auto outcome = res.win ? TranspositionTable::Win : TranspositionTable::Lose;
+        for (auto& v : path)
+            tt->store(v.hash, outcome, (uint32_t)(res.ticks - v.tick));
+    }
+    return true;
+}
+
+GameEngine::RunResult PlacementSolver::simulate(const GameEngine& base,
+                                                const std::vector<Placement>& placements,
+                                                int maxTicks,
+                                                TranspositionTable* tt,
+                                                uint64_t* ttHits)
+{
+    GameEngine eng = base.clone();
+    eng.setHistoryDepth(0);
+    eng.setCheckpointInterval(0);
+    for (auto& p : placements)
+        eng.addPlacedRobot(makeRobot(p));
+
+    GameEngine::RunResult res;
+    std::vector<Visit> path;
+
+    // мала карта — на бітбордах; непідтримуваний стан доганяє звичайний рушій
+    bool done = false;
+    withBitboardEngine(eng, [&](auto& bb) {
+        done = runWithTable(bb, maxTicks, res, tt, ttHits, path);
+        if (!done && res.ticks > 0) bb.store(eng);
+    });
+    if (!done) runWithTable(eng, maxTicks, res, tt, ttHits, path);
+
+    return res;
+}
+
+std::vector<GameEngine::RunResult> PlacementSolver::evaluate(
+    const GameEngine& base,
+    const std::vector<std::vector<Placement>>& candidates,
+    int maxTicks, int threads)
+{
+    std::vector<GameEngine::RunResult> results(candidates.size());
+    if (candidates.empty()) return results;
+
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    threads = std::max(1, std::min<int>(threads, (int)candidates.size()));
+
+    // схожі набори часто сходяться в однакові стани — таблиця спільна
+    TranspositionTable tt(candidates.size() > 64 ? 18 : 14);
+    std::atomic<size_t> next{0};
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < candidates.size(); i = next++)
+            results[i] = simulate(base, candidates[i], maxTicks, &tt);
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    return results;
+}
+
+void PlacementSolver::buildActions() {
+    const Level& lvl = base_.getLevel();
+    const int W = lvl.getWidth();
+    const int H = lvl.getHeight();
+
+    std::vector<char> occupied((size_t)W * H, 0);
+    auto mark = [&](const std::vector<std::unique_ptr<Robot>>& arr) {
+        for (auto& r : arr) {
+            auto* s = r->getState();
+            if (s && s->alive && lvl.isInside(s->x, s->y))
+                occupied[(size_t)s->y * W + s->x] = 1;
+        }
+    };
+    mark(lvl.getRobots());
+    mark(lvl.getPlacedRobots());
+
+    const Direction dirs[4] = { Direction::Up, Direction::Down, Direction::Left, Direction::Right };
+    const CommandType cmds[2] = { CommandType::RotateCW, CommandType::RotateCCW };
+
+    actions_.clear();
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            if (lvl.isWall(x, y) || occupied[(size_t)y * W + x]) continue;
+
+            if (opt_.maxWorkers > 0)
+                for (Direction d : dirs)
+                    actions_.push_back({ x, y, RobotType::Worker, d, CommandType::RotateCW });
+
+            if (opt_.maxControllers > 0)
+                for (Direction d : dirs)
+                    for (CommandType c : cmds)
+                        actions_.push_back({ x, y, RobotType::Controller, d, c });
+        }
+    }
+}
+
+// коробка, від якої стінами відрізані всі цілі, не буде доставлена ніколи
+bool PlacementSolver::provablyUnsolvable() const {
+    const Level& lvl = base_.getLevel();
+
+    for (auto& b : lvl.getBoxes())
+        if (!b.delivered && lvl.targetDistance(b.x, b.y) < 0) return true;
+    return false;
+}
+
+SolveResult PlacementSolver::solve() {
+    using Clock = std::chrono::steady_clock;
+    const auto started = Clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+    };
+
+    SolveResult res;
+    const int maxDepth = std::max(0, opt_.maxWorkers) + std::max(0, opt_.maxControllers);
+
+    if (provablyUnsolvable()) {
+        res.status = SolveResult::Status::Unsolvable;
+        res.depth = maxDepth;
+        res.elapsedMs = elapsedMs();
+        return res;
+    }
+
+    buildActions();
+    const size_t N = actions_.size();
+
+    // розстановки однієї клітинки йдуть підряд; наступна клітинка — з nextCell[i]
+    std::vector<size_t> nextCell(N, N);
+    for (size_t i = N; i-- > 0;) {
+        bool sameCell = i + 1 < N && actions_[i + 1].x == actions_[i].x && actions_[i + 1].y == actions_[i].y;
+        nextCell[i] = sameCell ? nextCell[i + 1] : i + 1;
+    }
+
+    TranspositionTable tt(opt_.ttLog2);
+
+    int threads = opt_.threads > 0 ? opt_.threads : (int)std::thread::hardware_concurrency();
+    threads = std::max(1, threads);
+
+    std::atomic<uint64_t> nodes{0};
+    std::atomic<uint64_t> ttHits{0};
+    std::atomic<bool> aborted{false};
+
+    auto countNode = [&]() {
+        uint64_t n = ++nodes;
+        if (opt_.maxNodes && n > opt_.maxNodes) aborted = true;
+        if (opt_.timeLimitMs > 0 && (n & 63) == 0 && elapsedMs() > opt_.timeLimitMs) aborted = true;
+    };
+
+    bool solved = false;
+
+    for (int depth = 0; depth <= maxDepth && !solved && !aborted; ++depth) {
+        if (depth == 0) {
+            countNode();
+            uint64_t hits = 0;
+            auto r = simulate(base_, {}, opt_.maxTicks, &tt, &hits);
+            ttHits += hits;
+            if (r.win) {
+                solved = true;
+                res.ticks = r.ticks;
+            }
+            if (!aborted) res.depth = 0;
+            continue;
+        }
+
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> bestFirst{std::numeric_limits<size_t>::max()};
+        std::mutex bestMutex;
+        std::vector<Placement> best;
+        int bestTicks = 0;
+
+        auto worker = [&]() {
+            std::vector<Placement> set;
+            set.reserve(depth);
+            uint64_t hits = 0;
+            size_t first = 0;
+
+            // true — знайдено розв'язок або пошук зупинено
+            auto dfs = [&](auto& self, size_t from, int workers, int ctrls) -> bool {
+                if ((int)set.size() == depth) {
+                    countNode();
+                    auto r = simulate(base_, set, opt_.maxTicks, &tt, &hits);
+                    if (!r.win) return aborted;
+
+                    std::lock_guard<std::mutex> lock(bestMutex);
+                    if (first < bestFirst) {
+                        bestFirst = first;
+                        best = set;
+                        bestTicks = r.ticks;
+                    }
+                    return true;
+                }
+
+                for (size_t i = from; i < N; ++i) {
+                    if (aborted || first > bestFirst) return true;
+
+                    const Placement& p = actions_[i];
+                    bool isWorker = p.type == RobotType::Worker;
+                    if (isWorker ? workers >= opt_.maxWorkers : ctrls >= opt_.maxControllers)
+                        continue;
+
+                    set.push_back(p);
+                    bool stop = self(self, nextCell[i], workers + (isWorker ? 1 : 0), ctrls + (isWorker ? 0 : 1));
+                    set.pop_back();
+                    if (stop) return true;
+                }
+                return false;
+            };
+
+            for (;;) {
+                first = next++;
+                if (first >= N || aborted || first > bestFirst) break;
+
+                const Placement& p = actions_[first];
+                bool isWorker = p.type == RobotType::Worker;
+                if (isWorker ? opt_.maxWorkers < 1 : opt_.maxControllers < 1) continue;
+
+                set.assign(1, p);
+                dfs(dfs, nextCell[first], isWorker ? 1 : 0, isWorker ? 0 : 1);
+            }
+
+            ttHits += hits;
+        };
+
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool) t.join();
+
+        if (bestFirst != std::numeric_limits<size_t>::max()) {
+            // менші перші індекси перевірені повністю, тож розв'язок остаточний
+            solved = true;
+            res.placements = best;
+            res.ticks = bestTicks;
+            res.depth = depth;
+        } else if (!aborted) {
+            res.depth = depth;
+        }
+    }
+
+    res.status = solved ? SolveResult::Status::Solved
+               : aborted ? SolveResult::Status::Limit
+               : SolveResult::Status::Unsolvable;
+    res.nodes = nodes;
+    res.ttHits = ttHits;
+    res.elapsedMs = elapsedMs();
+    return res;
+}
+
+json PlacementSolver::placementToJson(const Placement& p) {
+    json j{
+        {"type", p.type == RobotType::Worker ? "worker" : "controller"},
+        {"x", p.x},
+        {"y", p.y},
+        {"dir", dirName(p.dir)}
+    };
+    if (p.type == RobotType::Controller)
+        j["command"] = p.command == CommandType::RotateCCW ? "rotate_ccw" : "rotate_cw";
+    return j;
+}
+
+bool PlacementSolver::placementFromJson(const json& j, Placement& out) {
+    if (!j.is_object() || !j.contains("x") || !j.contains("y")) return false;
+
+    out.x = j.value("x", 0);
+    out.y = j.value("y", 0);
+    out.type = j.value("type", "worker") == "worker" ? RobotType::Worker : RobotType::Controller;
+    out.dir = dirFromName(j.value("dir", "up"));
+    out.command = j.value("command", "rotate_cw") == "rotate_ccw" ? CommandType::RotateCCW
+                                                                  : CommandType::RotateCW;
+    return true;
+}
+
+json PlacementSolver::resultToJson(const SolveResult& r) {
+    const char* status = r.status == SolveResult::Status::Solved ? "solved"
+                       : r.status == SolveResult::Status::Unsolvable ? "unsolvable"
+                       : "limit";
+
+    json placements = json::array();
+    for (auto& p : r.placements) placements.push_back(placementToJson(p));
+
+    return json{
+        {"result", status},
+        {"placements", placements},
+        {"ticks", r.ticks},
+        {"depth", r.depth},
+        {"nodes", r.nodes},
+        {"tt_hits", r.ttHits},
+        {"elapsed_ms", r.elapsedMs}
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "GameEngine.hpp"
+#include "TranspositionTable.hpp"
+
+// Один робот, якого гравець ставить перед стартом (як spawn_robot)
+struct Placement {
+    int x = 0;
+    int y = 0;
+    RobotType type = RobotType::Worker;
+    Direction dir = Direction::Up;
+    CommandType command = CommandType::RotateCW;   // лише для контролера
+};
+
+struct SolveOptions {
+    int maxWorkers = 1;
+    int maxControllers = 1;
+    int maxTicks = 10000;
+    int threads = 0;                  // 0 — усі ядра
+    uint64_t maxNodes = 5000000;      // скільки розстановок можна перевірити
+    int timeLimitMs = 0;              // 0 — без обмеження
+    unsigned ttLog2 = 20;
+};
+
+struct SolveResult {
+    enum class Status { Solved, Unsolvable, Limit };
+
+    Status status = Status::Limit;
+    std::vector<Placement> placements;
+    int ticks = 0;           // тривалість переможного прогону
+    int depth = 0;           // найбільша повністю перевірена кількість роботів
+    uint64_t nodes = 0;
+    uint64_t ttHits = 0;
+    double elapsedMs = 0;
+};
+
+// Пошук розстановки, що виграє рівень: ітеративне поглиблення за кількістю
+// роботів, на кожній глибині перебір наборів у канонічному порядку,
+// розпаралелений за першою розстановкою. Прогони діляться таблицею
+// результатів за хешем стану. Знайдений розв'язок — лексикографічно
+// найменший серед найкоротших, тож не залежить від кількості потоків.
+class PlacementSolver {
+public:
+    explicit PlacementSolver(const GameEngine& base, SolveOptions opt = {});
+
+    SolveResult solve();
+
+    static std::unique_ptr<Robot> makeRobot(const Placement& p);
+
+    // прогін розстановки до кінця на копії base; tt може бути nullptr
+    static GameEngine::RunResult simulate(const GameEngine& base,
+                                          const std::vector<Placement>& placements,
+                                          int maxTicks,
+                                          TranspositionTable* tt = nullptr,
+                                          uint64_t* ttHits = nullptr);
+
+    // прогін багатьох наборів розстановок паралельно, кожен на своїй копії base
+    static std::vector<GameEngine::RunResult> evaluate(const GameEngine& base,
+                                                       const std::vector<std::vector<Placement>>& candidates,
+                                                       int maxTicks, int threads = 0);
+
+    static nlohmann::json placementToJson(const Placement& p);
+    static bool placementFromJson(const nlohmann::json& j, Placement& out);
+    static nlohmann::json resultToJson(const SolveResult& r);
+
+private:
+    const GameEngine& base_;
+    SolveOptions opt_;
+    std::vector<Placement> actions_;
+
+    void buildActions();
+    bool provablyUnsolvable() const;
+};
@@ -0,0 +1,380 @@
+#include "ReplayLog.hpp"
+#include "RequestHandler.hpp"
+#include "LevelBinary.hpp"
+#include "LevelLoader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using json = nlohmann::json;
+
+bool isMutatingAction(const std::string& a) {
+    return a == "load_level" || a == "add_robot" || a == "place_robot" ||
+           a == "spawn_robot" || a == "step" || a == "run_step" || a == "run" ||
+           a == "run_until_finished" || a == "edit_placement" ||
+           a == "reset" || a == "reset_keep_placements" || a == "undo" || a == "rewind";
+}
+
+bool isTickAction(const std::string& a) {
+    return a == "step" || a == "run_step" || a == "run_until_finished";
+}
+
+// ===== СЕРІАЛІЗАЦІЯ СТАНУ =====
+
+template <typename T>
+static void put(std::vector<uint8_t>& out, T v) {
+    auto* p = reinterpret_cast<const uint8_t*>(&v);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+static bool get(const uint8_t*& p, const uint8_t* end, T& v) {
+    if ((size_t)(end - p) < sizeof(T)) return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+static void putSnapshot(std::vector<uint8_t>& out, const LevelSnapshot& s) {
+    put<int32_t>(out, s.moves);
+
+    put<uint32_t>(out, (uint32_t)s.robots.size());
+    for (auto& r : s.robots) {
+        const RobotState& st = r.state;
+        put<int32_t>(out, st.id);
+        put<uint8_t>(out, (uint8_t)st.type);
+        put<int32_t>(out, st.x);
+        put<int32_t>(out, st.y);
+        put<uint8_t>(out, st.alive);
+        put<uint8_t>(out, st.carrying);
+        put<int32_t>(out, st.boxId ? *st.boxId : -1);
+        put<uint8_t>(out, (uint8_t)st.dir);
+        put<uint8_t>(out, st.boosted);
+
+        put<uint8_t>(out, r.placed);
+        put<uint8_t>(out, r.listed);
+        put<uint8_t>(out, r.hasCommand);
+        put<int32_t>(out, r.command.robotId);
+        put<uint8_t>(out, (uint8_t)r.command.type);
+        put<uint8_t>(out, (uint8_t)r.command.dir);
+    }
+
+    put<uint32_t>(out, (uint32_t)s.boxes.size());
+    for (auto& b : s.boxes) {
+        put<int32_t>(out, b.id);
+        put<int32_t>(out, b.x);
+        put<int32_t>(out, b.y);
+        put<uint8_t>(out, b.delivered);
+    }
+}
+
+static bool getSnapshot(const uint8_t*& p, const uint8_t* end, LevelSnapshot& s) {
+    int32_t moves;
+    uint32_t n;
+    if (!get(p, end, moves) || !get(p, end, n)) return false;
+    s.moves = moves;
+    s.robots.resize(n);
+
+    for (auto& r : s.robots) {
+        int32_t id, x, y, box, cmdRobot;
+        uint8_t type, alive, carrying, dir, boosted, placed, listed, hasCmd, cmdType, cmdDir;
+
+        if (!get(p, end, id) || !get(p, end, type) || !get(p, end, x) || !get(p, end, y) ||
+            !get(p, end, alive) || !get(p, end, carrying) || !get(p, end, box) ||
+            !get(p, end, dir) || !get(p, end, boosted) || !get(p, end, placed) ||
+            !get(p, end, listed) || !get(p, end, hasCmd) || !get(p, end, cmdRobot) ||
+            !get(p, end, cmdType) || !get(p, end, cmdDir))
+            return false;
+
+        r.state.id = id;
+        r.state.type = (RobotType)type;
+        r.state.x = x;
+        r.state.y = y;
+        r.state.alive = alive;
+        r.state.carrying = carrying;
+        r.state.boxId = box >= 0 ? std::optional<int>(box) : std::nullopt;
+        r.state.dir = (Direction)dir;
+        r.state.boosted = boosted;
+        r.placed = placed;
+        r.listed = listed;
+        r.hasCommand = hasCmd;
+        r.command = Command{ cmdRobot, (CommandType)cmdType, (Direction)cmdDir };
+    }
+
+    if (!get(p, end, n)) return false;
+    s.boxes.resize(n);
+    for (auto& b : s.boxes) {
+        int32_t id, x, y;
+        uint8_t delivered;
+        if (!get(p, end, id) || !get(p, end, x) || !get(p, end, y) || !get(p, end, delivered))
+            return false;
+        b = Box{ id, x, y, delivered != 0 };
+    }
+    return true;
+}
+
+// ===== ЗАПИС =====
+
+bool ReplayWriter::open(const std::string& path, uint32_t keyframeInterval, const GameEngine& eng) {
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_.is_open()) return false;
+
+    interval_ = keyframeInterval;
+    tick_ = 0;
+    lastKeyframe_ = 0;
+    seenEpoch_ = UINT64_MAX;
+    written_.clear();
+
+    ReplayFileHeader hdr{};
+    std::memcpy(hdr.magic, REPLAY_FILE_MAGIC, 4);
+    hdr.version = REPLAY_FILE_VERSION;
+    hdr.keyframeInterval = keyframeInterval;
+    hdr.historyDepth = eng.historyDepth();
+    hdr.checkpointInterval = eng.checkpointInterval();
+    hdr.earlyLose = eng.earlyLose();
+    hdr.fastForward = eng.fastForward();
+    hdr.bitboard = eng.bitboard();
+    out_.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    out_.flush();
+    return (bool)out_;
+}
+
+void ReplayWriter::write(ReplayRecordType type, const std::vector<uint8_t>& payload) {
+    ReplayRecordHeader rh{ (uint8_t)type, tick_, (uint32_t)payload.size() };
+    out_.write(reinterpret_cast<const char*>(&rh), sizeof(rh));
+    out_.write(reinterpret_cast<const char*>(payload.data()), (std::streamsize)payload.size());
+}
+
+void ReplayWriter::writeKeyframe(const GameEngine& eng) {
+    std::vector<uint8_t> kf;
+
+    // бачені стани першими: seek збирає їх ланцюжком keyframe-ів,
+    // не розбираючи знімків
+    const bool continues = eng.seenEpoch() == seenEpoch_;
+    if (!continues) {
+        written_.clear();
+        seenEpoch_ = eng.seenEpoch();
+    }
+    std::vector<uint64_t> fresh;
+    eng.seenStates().forEach([&](uint64_t h) {
+        if (written_.insert(h).second) fresh.push_back(h);
+    });
+
+    put<uint8_t>(kf, continues);
+    put<uint32_t>(kf, (uint32_t)fresh.size());
+    for (uint64_t h : fresh) put<uint64_t>(kf, h);
+
+    put<uint8_t>(kf, eng.hadManualCommands());
+    put<uint8_t>(kf, eng.isNonTerminating());
+    put<uint8_t>(kf, eng.isRunning());
+    putSnapshot(kf, eng.saveState());
+
+    const LevelSnapshot* started = eng.getStartedSnapshot();
+    put<uint8_t>(kf, started != nullptr);
+    if (started) putSnapshot(kf, *started);
+
+    write(ReplayRecordType::Keyframe, kf);
+    lastKeyframe_ = tick_;
+}
+
+void ReplayWriter::record(const json& req, const json& resp, const GameEngine& eng) {
+    if (!out_.is_open()) return;
+
+    std::string action = req.value("action", "");
+    if (!isMutatingAction(action)) return;
+
+    // хід симуляції, а не кількість запитів: run_until_finished просуває
+    // його на скільки завгодно, reset і undo повертають назад
+    tick_ = (uint32_t)std::max(0, eng.getLevel().getMoves());
+    if (tick_ < lastKeyframe_) lastKeyframe_ = tick_;
+
+    if (action == "load_level") {
+        // рівень вбудовується у журнал, щоб не залежати від файлу на диску
+        if (resp.value("status", "") != "ok") return;
+        auto blob = LevelCompiler::compile(eng.getLevel());
+        write(ReplayRecordType::Load, std::vector<uint8_t>(blob.begin(), blob.end()));
+    } else {
+        write(ReplayRecordType::Request, json::to_msgpack(req));
+
+        // після undo/rewind історія ходів не відновлюється з журналу,
+        // тому результат фіксується keyframe-ом
+        bool periodic = isTickAction(action) && interval_ > 0 && tick_ >= lastKeyframe_ + interval_;
+        if (periodic || action == "undo" || action == "rewind")
+            writeKeyframe(eng);
+    }
+
+    out_.flush();
+}
+
+// ===== ЧИТАННЯ =====
+
+bool ReplayReader::open(const std::string& path) {
+    records_.clear();
+    keyframes_.clear();
+
+    if (!file_.open(path)) return false;
+
+    const uint8_t* data = file_.data();
+    size_t size = file_.size();
+
+    ReplayFileHeader hdr;
+    if (size < sizeof(hdr)) return false;
+    std::memcpy(&hdr, data, sizeof(hdr));
+    if (std::memcmp(hdr.magic, REPLAY_FILE_MAGIC, 4) != 0 || hdr.version != REPLAY_FILE_VERSION)
+        return false;
+    header_ = hdr;
+    interval_ = hdr.keyframeInterval;
+
+    // індекс будується лише за заголовками записів
+    size_t off = sizeof(hdr);
+    while (off + sizeof(ReplayRecordHeader) <= size) {
+        ReplayRecordHeader rh;
+        std::memcpy(&rh, data + off, sizeof(rh));
+        off += sizeof(rh);
+
+        if (rh.size > size - off) break;   // обірваний хвіст після аварії
+
+        // рівні перевіряються тут один раз: seek завантажує їх знову й знову
+        if (rh.type == (uint8_t)ReplayRecordType::Load &&
+            !LevelLoader::binaryHashMatches(data + off, rh.size))
+        {
+            std::cerr << "Replay level record is corrupted at offset " << off << std::endl;
+            break;
+        }
+
+        if (rh.type == (uint8_t)ReplayRecordType::Keyframe)
+            keyframes_.push_back(records_.size());
+
+        records_.push_back(Record{ (ReplayRecordType)rh.type, rh.tick, off, rh.size });
+        off += rh.size;
+    }
+    return true;
+}
+
+void ReplayReader::applySettings(GameEngine& eng) const {
+    eng.setHistoryDepth((size_t)header_.historyDepth);
+    eng.setCheckpointInterval(header_.checkpointInterval);
+    eng.setEarlyLose(header_.earlyLose != 0);
+    eng.setFastForward(header_.fastForward != 0);
+    eng.setBitboard(header_.bitboard != 0);
+}
+
+bool ReplayReader::apply(GameEngine& eng, RequestHandler& handler, size_t index) const {
+    const Record& r = records_[index];
+    const uint8_t* p = file_.data() + r.offset;
+
+    switch (r.type) {
+        case ReplayRecordType::Load: {
+            auto lvl = LevelLoader::loadFromBinary(p, r.size, false);
+            if (!lvl) return false;
+            eng.loadLevel(std::move(*lvl));
+            return true;
+        }
+
+        case ReplayRecordType::Request: {
+            json req = json::from_msgpack(p, p + r.size);
+
+            // найчастіший запит — напряму, без побудови JSON-відповіді
+            if (req.value("action", "") == "run_step") {
+                eng.stepAuto();
+                return true;
+            }
+
+            handler.handle(req);
+            return true;
+        }
+
+        case ReplayRecordType::Keyframe:
+            return applyKeyframe(eng, index);
+    }
+    return false;
+}
+
+bool ReplayReader::applyKeyframe(GameEngine& eng, size_t index) const {
+    auto pos = std::lower_bound(keyframes_.begin(), keyframes_.end(), index);
+    if (pos == keyframes_.end() || *pos != index) return false;
+
+    // бачені стани: цей keyframe і попередні, поки множина продовжується
+    std::vector<uint64_t> seen;
+    const uint8_t* p = nullptr;
+    const uint8_t* end = nullptr;
+    for (auto k = pos;; --k) {
+        const Record& r = records_[*k];
+        const uint8_t* q = file_.data() + r.offset;
+        const uint8_t* qend = q + r.size;
+        uint8_t continues;
+        uint32_t n;
+        if (!get(q, qend, continues) || !get(q, qend, n) || (size_t)(qend - q) / 8 < n) return false;
+
+        size_t old = seen.size();
+        seen.resize(old + n);
+        std::memcpy(seen.data() + old, q, (size_t)n * 8);
+        q += (size_t)n * 8;
+
+        if (k == pos) { p = q; end = qend; }
+        if (!continues || k == keyframes_.begin()) break;
+    }
+
+    uint8_t manual, nonTerminating, running, hasStarted;
+    LevelSnapshot snap, started;
+    if (!get(p, end, manual) || !get(p, end, nonTerminating) || !get(p, end, running) ||
+        !getSnapshot(p, end, snap) || !get(p, end, hasStarted))
+        return false;
+    if (hasStarted && !getSnapshot(p, end, started))
+        return false;
+
+    eng.restoreState(snap, running != 0, hasStarted ? &started : nullptr);
+    eng.restoreRun(manual != 0, nonTerminating != 0, seen);
+    return true;
+}
+
+bool ReplayReader::seek(GameEngine& eng, RequestHandler& handler, uint32_t tick,
+                        size_t* replayed) const
+{
+    // перший запис, після якого симуляція дійшла до tick
+    size_t target = 0;
+    while (target < records_.size() && records_[target].tick < tick) ++target;
+
+    // останній keyframe перед ним
+    auto kf = std::lower_bound(keyframes_.begin(), keyframes_.end(), target);
+
+    size_t start = 0;
+    if (kf != keyframes_.begin()) {
+        size_t k = *std::prev(kf);
+
+        // рельєф і початковий стан — з останнього Load перед keyframe
+        size_t load = k;
+        while (load > 0 && records_[load].type != ReplayRecordType::Load) --load;
+        if (records_[load].type != ReplayRecordType::Load) return false;
+
+        if (!apply(eng, handler, load) || !apply(eng, handler, k)) return false;
+        start = k + 1;
+    }
+
+    size_t count = 0;
+    for (size_t i = start; i < target; ++i) {
+        if (!apply(eng, handler, i)) return false;
+        ++count;
+    }
+
+    if (target < records_.size()) {
+        const Record& r = records_[target];
+        const uint8_t* p = file_.data() + r.offset;
+
+        // лише run_until_finished просуває більш ніж на хід за запит; до
+        // tick — тими самими ходами, тільки з меншою межею
+        bool overshoot = r.type == ReplayRecordType::Request && r.tick > tick &&
+            json::from_msgpack(p, p + r.size).value("action", "") == "run_until_finished";
+        if (overshoot) {
+            int moves = eng.getLevel().getMoves();
+            while (moves < (int)tick && !eng.isFinished())
+                moves += eng.advance((int)tick - moves);
+        } else if (!apply(eng, handler, target)) {
+            return false;
+        }
+        ++count;
+    }
+
+    if (replayed) *replayed = count;
+    return true;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "GameEngine.hpp"
+#include "MappedFile.hpp"
+
+class RequestHandler;
+
+// Журнал відтворення (.oopr), лише дозапис:
+//   ReplayFileHeader, далі записи { ReplayRecordHeader, payload }.
+//   Load     — скомпільований рівень (.lvlb), замінює load_level з диска
+//   Request  — інший змінюючий запит у MessagePack
+//   Keyframe — повний динамічний стан рушія після ходу tick
+//              (кожні keyframeInterval ходів і після кожного undo/rewind):
+//              бачені стани прогону, прапорці прогону, знімки рівня.
+//              Бачені стани — лише нові відносно попереднього keyframe, якщо
+//              множину відтоді не очищали (continues = 1).
+enum class ReplayRecordType : uint8_t { Load = 1, Request = 2, Keyframe = 3 };
+
+constexpr char     REPLAY_FILE_MAGIC[4] = { 'O', 'O', 'P', 'R' };
+constexpr uint32_t REPLAY_FILE_VERSION  = 2;
+
+#pragma pack(push, 1)
+struct ReplayFileHeader {
+    char     magic[4];
+    uint32_t version;
+    uint32_t keyframeInterval;
+    // налаштування рушія, з якими записано сесію
+    uint64_t historyDepth;
+    int32_t  checkpointInterval;
+    uint8_t  earlyLose;
+    uint8_t  fastForward;
+    uint8_t  bitboard;
+    uint8_t  reserved;
+};
+
+struct ReplayRecordHeader {
+    uint8_t  type;
+    uint32_t tick;      // хід симуляції (Level::getMoves) після цього запису
+    uint32_t size;
+};
+#pragma pack(pop)
+
+class ReplayWriter {
+public:
+    // налаштування eng пишуться в заголовок
+    bool open(const std::string& path, uint32_t keyframeInterval, const GameEngine& eng);
+    bool isOpen() const { return out_.is_open(); }
+
+    // викликається після обробки запиту; незмінюючі запити пропускаються
+    void record(const nlohmann::json& req, const nlohmann::json& resp, const GameEngine& eng);
+
+    uint32_t tick() const { return tick_; }
+
+private:
+    std::ofstream out_;
+    uint32_t interval_ = 0;
+    uint32_t tick_ = 0;
+    uint32_t lastKeyframe_ = 0;
+
+    // бачені стани, вже записані в keyframe-и поточної епохи seen_
+    uint64_t seenEpoch_ = UINT64_MAX;
+    std::unordered_set<uint64_t> written_;
+
+    void write(ReplayRecordType type, const std::vector<uint8_t>& payload);
+    void writeKeyframe(const GameEngine& eng);
+};
+
+class ReplayReader {
+public:
+    struct Record {
+        ReplayRecordType type;
+        uint32_t tick;
+        size_t offset;   // початок payload
+        uint32_t size;
+    };
+
+    bool open(const std::string& path);
+
+    const std::vector<Record>& records() const { return records_; }
+    uint32_t lastTick() const { return records_.empty() ? 0 : records_.back().tick; }
+    uint32_t keyframeInterval() const { return interval_; }
+
+    // налаштування рушія із заголовка; до відтворення
+    void applySettings(GameEngine& eng) const;
+
+    // Запити відтворюються через handler, прив'язаний до eng: один на все
+    // відтворення, як і в записаному сеансі.
+
+    // Стан, коли симуляція вперше дійшла до ходу tick: найближчий keyframe
+    // + відтворення вперед. run_until_finished, що перескакує tick,
+    // доганяється ходами лише до нього. Якщо tick так і не досягнуто —
+    // стан у кінці журналу.
+    bool seek(GameEngine& eng, RequestHandler& handler, uint32_t tick,
+              size_t* replayed = nullptr) const;
+
+    // Усі записи з початку; onTick викликається після кожного запису, що
+    // змінив хід. Keyframe-и пропускаються: з тими ж налаштуваннями рушія
+    // відтворення від початку й так точне, вони потрібні лише seek.
+    // simulated — скільки ходів справді прораховано (відкати й нові
+    // завантаження не віднімаються)
+    template <typename F> bool replayAll(GameEngine& eng, RequestHandler& handler, F&& onTick,
+                                         uint64_t* simulated = nullptr) const;
+
+    // index — у records()
+    bool apply(GameEngine& eng, RequestHandler& handler, size_t index) const;
+
+private:
+    MappedFile file_;
+    ReplayFileHeader header_{};
+    uint32_t interval_ = 0;
+    std::vector<Record> records_;
+    std::vector<size_t> keyframes_;   // індекси у records_
+
+    bool applyKeyframe(GameEngine& eng, size_t index) const;
+};
+
+template <typename F>
+bool ReplayReader::replayAll(GameEngine& eng, RequestHandler& handler, F&& onTick,
+                             uint64_t* simulated) const
+{
+    uint32_t tick = 0;
+    for (size_t i = 0; i < records_.size(); ++i) {
+        const Record& r = records_[i];
+        if (r.type == ReplayRecordType::Keyframe) continue;
+
+        int before = eng.getLevel().getMoves();
+        if (!apply(eng, handler, i)) return false;
+        int after = eng.getLevel().getMoves();
+        if (simulated && after > before) *simulated += (uint64_t)(after - before);
+
+        if (r.tick != tick) {
+            tick = r.tick;
+            onTick(tick);
+        }
+    }
+    return true;
+}
+
+bool isMutatingAction(const std::string& action);
+bool isTickAction(const std::string& action);
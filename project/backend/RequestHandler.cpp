@@ -3,6 +3,10 @@
 #include "LevelLoader.hpp"
 #include "WorkerRobot.hpp"
 #include "ControllerRobot.hpp"
+#include "ReplayLog.hpp"
+#include "PlacementSolver.hpp"
+#include "MultiAgentPlanner.hpp"
+#include "Metrics.hpp"
 
 #include <nlohmann/json.hpp>
 #include <iostream>
@@ -17,9 +21,25 @@ static Direction strToDir(const std::string& s) {
     return Direction::Up;
 }
 
+static const char* dirToStr(Direction d) {
+    switch (d) {
+        case Direction::Up: return "up";
+        case Direction::Down: return "down";
+        case Direction::Left: return "left";
+        case Direction::Right: return "right";
+    }
+    return "up";
+}
+
 RequestHandler::RequestHandler(GameEngine& engine) : eng_(engine) {}
 
 json RequestHandler::handle(const json& req) {
+    json resp = dispatch(req);
+    if (recorder_) recorder_->record(req, resp, eng_);
+    return resp;
+}
+
+json RequestHandler::dispatch(const json& req) {
     std::string action = req.value("action", "");
 
     // ----------------- LOAD LEVEL -----------------
@@ -28,7 +48,7 @@ json RequestHandler::handle(const json& req) {
             std::string path = req.at("path").get<std::string>();
             std::cerr << "[RequestHandler] load_level path=" << path << std::endl;
 
-            auto opt = LevelLoader::loadFromJson(path);
+            auto opt = cache_.load(path);
             if (!opt)
                 return json{{"status","error"},{"message","cannot load level"}};
 
@@ -42,12 +62,264 @@ json RequestHandler::handle(const json& req) {
         return json{{"status","ok"},{"state", st["state"]}};
     }
 
+    // ----------------- RESET -----------------
+    if (action == "reset" || action == "reset_keep_placements") {
+        if (action == "reset") eng_.reset();
+        else eng_.resetKeepPlacements();
+
+        auto st = eng_.getStateJson();
+        return json{{"status","ok"},{"state", st["state"]}};
+    }
+
+    // ----------------- UNDO / REWIND -----------------
+    if (action == "undo" || action == "rewind") {
+        int n = action == "undo" ? 1 : req.value("n", 1);
+        if (n < 0) n = 0;
+
+        size_t undone = eng_.undo((size_t)n);
+
+        auto st = eng_.getStateJson();
+        return json{{"status","ok"},{"state", st["state"]},{"undone", undone}};
+    }
+
     // ----------------- STATUS -----------------
     if (action == "status") {
         auto st = eng_.getStateJson();
         return json{{"status","ok"},{"state", st["state"]}};
     }
 
+    // ----------------- METRICS -----------------
+    if (action == "metrics") {
+        if (!metrics_)
+            return json{{"status","error"},{"message","metrics are not collected"}};
+
+        return json{{"status","ok"},{"metrics", metrics_->toJson()}};
+    }
+
+    // ----------------- SOLVE -----------------
+    // пошук розстановки для поточного рівня; сам стан гри не змінюється
+    if (action == "solve") {
+        if (eng_.isRunning())
+            return json{{"status","error"},{"message","game already started"}};
+
+        SolveOptions opt;
+        opt.maxWorkers     = req.value("max_workers", opt.maxWorkers);
+        opt.maxControllers = req.value("max_controllers", opt.maxControllers);
+        opt.maxTicks       = req.value("max_ticks", opt.maxTicks);
+        opt.maxNodes       = req.value("max_nodes", opt.maxNodes);
+        opt.timeLimitMs    = req.value("time_limit_ms", opt.timeLimitMs);
+        opt.threads        = req.value("threads", opt.threads);
+
+        json out = PlacementSolver::resultToJson(PlacementSolver(eng_, opt).solve());
+        out["status"] = "ok";
+        return out;
+    }
+
+    // ----------------- EVALUATE PLACEMENTS -----------------
+    // candidates: масив наборів розстановок у форматі spawn_robot;
+    // кожен набір проганяється до кінця на копії поточного рівня
+    if (action == "evaluate_placements") {
+        if (eng_.isRunning())
+            return json{{"status","error"},{"message","game already started"}};
+
+        if (!req.contains("candidates") || !req["candidates"].is_array())
+            return json{{"status","error"},{"message","candidates must be an array"}};
+
+        std::vector<std::vector<Placement>> candidates;
+        for (auto& c : req["candidates"]) {
+            if (!c.is_array())
+                return json{{"status","error"},{"message","each candidate must be an array of placements"}};
+
+            std::vector<Placement> set;
+            for (auto& p : c) {
+                Placement pl;
+                if (!PlacementSolver::placementFromJson(p, pl))
+                    return json{{"status","error"},{"message","placement needs x and y"}};
+                set.push_back(pl);
+            }
+            candidates.push_back(std::move(set));
+        }
+
+        auto runs = PlacementSolver::evaluate(eng_, candidates,
+                                              req.value("max_ticks", 100000),
+                                              req.value("threads", 0));
+
+        json results = json::array();
+        for (auto& r : runs) {
+            results.push_back({
+                {"win", r.win},
+                {"lose", r.lose},
+                {"ticks", r.ticks},
+                {"non_terminating", r.nonTerminating}
+            });
+        }
+        return json{{"status","ok"},{"results", results}};
+    }
+
+    // ----------------- RAY QUERY -----------------
+    // відстань до найближчої стіни або краю; робітник, що йде прямо,
+    // гине на ході distance + 1
+    if (action == "ray_query") {
+        const Level& lvl = eng_.getLevel();
+        int x = req.value("x", 0);
+        int y = req.value("y", 0);
+
+        if (!lvl.isInside(x, y))
+            return json{{"status","error"},{"message","cell is outside the level"}};
+
+        if (req.contains("dir")) {
+            Direction d = strToDir(req.value("dir", "up"));
+            return json{{"status","ok"},{"distance", lvl.rayDistance(x, y, d)}};
+        }
+
+        return json{{"status","ok"},{"rays", {
+            {"up",    lvl.rayDistance(x, y, Direction::Up)},
+            {"down",  lvl.rayDistance(x, y, Direction::Down)},
+            {"left",  lvl.rayDistance(x, y, Direction::Left)},
+            {"right", lvl.rayDistance(x, y, Direction::Right)}
+        }}};
+    }
+
+    // ----------------- PATH -----------------
+    // найкоротший шлях між клітинками по рельєфу (роботи й коробки не заважають)
+    if (action == "path") {
+        const Level& lvl = eng_.getLevel();
+        if (!req.contains("from") || !req.contains("to"))
+            return json{{"status","error"},{"message","from and to are required"}};
+
+        int sx = req["from"].value("x", 0), sy = req["from"].value("y", 0);
+        int tx = req["to"].value("x", 0), ty = req["to"].value("y", 0);
+
+        if (!lvl.isInside(sx, sy) || !lvl.isInside(tx, ty))
+            return json{{"status","error"},{"message","cell is outside the level"}};
+
+        // bfs — кешовані поля відстаней; jps — пошук без полів, для великих карт;
+        // hpa — граф кластерів, шлях майже найкоротший
+        std::string algo = req.value("algo", "bfs");
+        if (algo != "bfs" && algo != "jps" && algo != "hpa")
+            return json{{"status","error"},{"message","unknown algo: " + algo}};
+
+        const bool wantCells = req.value("cells", true);
+        std::vector<std::pair<int,int>> path;
+        int distance;
+        if (algo == "jps") {
+            path = jps_.path(lvl, sx, sy, tx, ty);
+            distance = (int)path.size() - 1;
+        } else if (algo == "hpa") {
+            if (wantCells) {
+                path = clusters_.path(lvl, sx, sy, tx, ty);
+                distance = (int)path.size() - 1;
+            } else {
+                distance = clusters_.distance(lvl, sx, sy, tx, ty);
+            }
+        } else {
+            distance = paths_.distance(lvl, sx, sy, tx, ty);
+            if (wantCells) path = paths_.path(lvl, sx, sy, tx, ty);
+        }
+
+        json resp{{"status","ok"},{"distance", distance}};
+        if (wantCells) {
+            json cells = json::array();
+            for (auto& c : path) cells.push_back({ c.first, c.second });
+            resp["path"] = cells;
+        }
+        return resp;
+    }
+
+    // ----------------- FLOW STEER -----------------
+    // перший крок до цілі для багатьох роботів за одне поле напрямків
+    if (action == "flow_steer") {
+        const Level& lvl = eng_.getLevel();
+        const int W = lvl.getWidth();
+
+        const std::vector<uint8_t>* flow;
+        if (req.contains("target")) {
+            int tx = req["target"].value("x", 0), ty = req["target"].value("y", 0);
+            if (!lvl.isInside(tx, ty))
+                return json{{"status","error"},{"message","cell is outside the level"}};
+            flow = &paths_.flow(lvl, tx, ty);
+        } else {
+            flow = &paths_.flowToTargets(lvl);
+        }
+
+        // клітинки з запиту або всі живі робітники
+        std::vector<int32_t> cells;
+        std::vector<int> ids;
+        const bool byCells = req.contains("cells");
+        if (byCells) {
+            for (auto& c : req["cells"]) {
+                int x = c.at(0).get<int>(), y = c.at(1).get<int>();
+                cells.push_back(lvl.isInside(x, y) ? y * W + x : -1);
+            }
+        } else {
+            auto collect = [&](const std::vector<std::unique_ptr<Robot>>& arr) {
+                for (auto& r : arr) {
+                    auto* st = r->getState();
+                    if (!st || !st->alive || st->type != RobotType::Worker) continue;
+                    ids.push_back(st->id);
+                    cells.push_back(lvl.isInside(st->x, st->y) ? st->y * W + st->x : -1);
+                }
+            };
+            collect(lvl.getRobots());
+            collect(lvl.getPlacedRobots());
+        }
+
+        std::vector<uint8_t> dirs;
+        PathService::steer(*flow, cells, dirs);
+
+        json out = json::array();
+        for (size_t i = 0; i < dirs.size(); ++i) {
+            json d = dirs[i] == PathService::NoFlow ? json(nullptr) : json(dirToStr((Direction)dirs[i]));
+            if (byCells) out.push_back(d);
+            else out.push_back({{"id", ids[i]}, {"dir", d}});
+        }
+        return json{{"status","ok"},{"directions", out}};
+    }
+
+    // ----------------- PLAN PATHS -----------------
+    // безконфліктні шляхи для кількох робітників; ticks[t] — готові
+    // commands для step на тіку t
+    if (action == "plan_paths") {
+        const Level& lvl = eng_.getLevel();
+        if (!req.contains("goals") || !req["goals"].is_array())
+            return json{{"status","error"},{"message","goals must be an array"}};
+
+        std::vector<PlanGoal> goals;
+        for (auto& g : req["goals"]) {
+            if (!g.is_object() || !g.contains("id") || !g.contains("x") || !g.contains("y"))
+                return json{{"status","error"},{"message","each goal needs id, x and y"}};
+
+            PlanGoal pg{ g["id"].get<int>(), g["x"].get<int>(), g["y"].get<int>() };
+            if (!lvl.isInside(pg.x, pg.y) || lvl.isWall(pg.x, pg.y))
+                return json{{"status","error"},{"message","goal is outside the level or in a wall"}};
+
+            const RobotState* st = nullptr;
+            for (auto* arr : { &lvl.getRobots(), &lvl.getPlacedRobots() })
+                for (auto& r : *arr)
+                    if (r->getState() && r->getState()->id == pg.robotId) st = r->getState();
+            if (!st || !st->alive || st->type != RobotType::Worker)
+                return json{{"status","error"},{"message","robot " + std::to_string(pg.robotId) + " is not a live worker"}};
+
+            for (auto& other : goals) {
+                if (other.robotId == pg.robotId)
+                    return json{{"status","error"},{"message","robot listed twice"}};
+                if (other.x == pg.x && other.y == pg.y)
+                    return json{{"status","error"},{"message","goals must be distinct"}};
+            }
+            goals.push_back(pg);
+        }
+
+        PlanOptions opt;
+        opt.maxTicks  = req.value("max_ticks", opt.maxTicks);
+        opt.threads   = req.value("threads", opt.threads);
+        opt.orderings = req.value("orderings", opt.orderings);
+        opt.seed      = req.value("seed", opt.seed);
+
+        json out = MultiAgentPlanner::resultToJson(MultiAgentPlanner(eng_, paths_, opt).plan(goals));
+        out["status"] = "ok";
+        return out;
+    }
+
     // ----------------- ADD ROBOT -----------------
     if (action == "add_robot") {
         //if (eng_.isLocked())
@@ -160,7 +432,7 @@ json RequestHandler::handle(const json& req) {
         r->setDirection(strToDir(dir));
 
         if (type == "controller" && req.contains("command")) {
-            Command C;
+            Command C{};
             std::string cmdStr = req["command"];
 
             if (cmdStr == "rotate_cw")  C.type = CommandType::RotateCW;
@@ -184,6 +456,39 @@ json RequestHandler::handle(const json& req) {
 }
 
     
+    // ----------------- EDIT PLACEMENT -----------------
+    // зміна клітинки, напрямку чи команди розставленого робота до старту;
+    // незадані поля лишаються як були
+    if (action == "edit_placement") {
+        if (eng_.isRunning())
+            return json{{"status","error"},{"message","game already started"}};
+
+        int id = req.value("id", -1);
+        const RobotState* cur = nullptr;
+        for (auto& r : eng_.getLevel().getPlacedRobots())
+            if (r->getState() && r->getState()->id == id) cur = r->getState();
+        if (!cur)
+            return json{{"status","error"},{"message","no placed robot with this id"}};
+
+        int x = req.value("x", cur->x);
+        int y = req.value("y", cur->y);
+        Direction dir = req.contains("dir") ? strToDir(req.value("dir", "up")) : cur->dir;
+
+        std::optional<CommandType> command;
+        if (req.contains("command")) {
+            std::string cmdStr = req.value("command", "");
+            if (cmdStr == "rotate_cw") command = CommandType::RotateCW;
+            else if (cmdStr == "rotate_ccw") command = CommandType::RotateCCW;
+            else return json{{"status","error"},{"message","unknown command: " + cmdStr}};
+        }
+
+        if (!eng_.editPlacement(id, x, y, dir, command))
+            return json{{"status","error"},{"message","cannot edit placement"}};
+
+        auto st = eng_.getStateJson();
+        return json{{"status","ok"},{"state", st["state"]}};
+    }
+
     // ----------------- RUN STEP -----------------
     if (action == "run_step") {
 
@@ -196,13 +501,34 @@ json RequestHandler::handle(const json& req) {
         // 3) Перевіряємо завершення гри
         bool win  = eng_.isWin();
         bool lose = eng_.isLose();
+        bool loop = eng_.isNonTerminating();
 
         return json{
             {"status", "ok"},
             {"state",  st["state"]},
-            {"finished", win || lose},
+            {"finished", win || lose || loop},
             {"win", win},
-            {"lose", lose}
+            {"lose", lose},
+            {"non_terminating", loop}
+        };
+    }
+
+    // ----------------- RUN UNTIL FINISHED -----------------
+    if (action == "run_until_finished") {
+        int maxTicks = req.value("max_ticks", 100000);
+
+        auto res = eng_.runUntilFinished(maxTicks);
+        auto st = eng_.getStateJson();
+
+        return json{
+            {"status", "ok"},
+            {"state",  st["state"]},
+            {"ticks", res.ticks},
+            {"resumed_from", res.resumedFrom},
+            {"finished", res.win || res.lose || res.nonTerminating},
+            {"win", res.win},
+            {"lose", res.lose},
+            {"non_terminating", res.nonTerminating}
         };
     }
 
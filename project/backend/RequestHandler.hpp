@@ -1,18 +1,42 @@
 #pragma once
 #include "GameEngine.hpp"
 #include "Types.hpp"
+#include "LevelCache.hpp"
+#include "PathService.hpp"
+#include "JumpPointSearch.hpp"
+#include "ClusterGraph.hpp"
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
+class ReplayWriter;
+class Metrics;
+
 class RequestHandler {
 public:
     explicit RequestHandler(GameEngine& engine);
 
     json handle(const json& req);
 
+    LevelCache& levelCache() { return cache_; }
+    PathService& pathService() { return paths_; }
+
+    // журнал змінюючих запитів (nullptr — вимкнено)
+    void setRecorder(ReplayWriter* w) { recorder_ = w; }
+
+    // лічильники для дії metrics (nullptr — дія відповідає помилкою)
+    void setMetrics(const Metrics* m) { metrics_ = m; }
+
 private:
     GameEngine& eng_;
+    LevelCache cache_;
+    PathService paths_;
+    JumpPointSearch jps_;
+    ClusterGraph clusters_;
+    ReplayWriter* recorder_ = nullptr;
+    const Metrics* metrics_ = nullptr;
+
+    json dispatch(const json& req);
 
     Command parseCommand(const json& j);
 };
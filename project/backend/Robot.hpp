@@ -1,6 +1,7 @@
 #pragma once
 #include "Types.hpp"
 #include <optional>
+#include <memory>
 
 class Robot {
 protected:
@@ -14,6 +15,7 @@ public:
 
     void attachState(RobotState* s) { state = s; }
     RobotState* getState() { return state; }
+    const RobotState* getState() const { return state; }
 
     void setPosition(int x, int y) { pending_x = x; pending_y = y; }
     int getPendingX() const { return pending_x; }
@@ -23,5 +25,6 @@ public:
     Direction getDirection() const { return pending_dir; }
 
     virtual RobotType getType() const = 0;
+    virtual std::unique_ptr<Robot> clone() const = 0;
     virtual void execute(const Command& cmd, WorldView& world) = 0;
 };
@@ -0,0 +1,175 @@
+#include "RunTrace.hpp"
+#include "Level.hpp"
+#include <algorithm>
+
+RunTrace& RunTrace::operator=(const RunTrace& other) {
+    if (this != &other) {
+        clear();
+        interval_ = other.interval_;
+    }
+    return *this;
+}
+
+void RunTrace::setInterval(int ticks) {
+    interval_ = std::max(0, ticks);
+    clear();
+}
+
+void RunTrace::clear() {
+    valid_ = false;
+    tick_ = 0;
+    editedIds_.clear();
+    resumeLimit_ = INT_MAX;
+    checkpoints_.clear();
+    segments_.clear();
+    open_.clear();
+}
+
+void RunTrace::begin(const Level& lvl) {
+    clear();
+    if (interval_ <= 0) return;
+
+    valid_ = true;
+    checkpoints_.push_back({ 0, lvl.snapshot() });
+    recordWorkers(lvl);
+}
+
+void RunTrace::advance(int ticks, const Level& lvl) {
+    if (!valid_) return;
+
+    int before = tick_;
+    tick_ += ticks;
+    recordWorkers(lvl);
+
+    if (tick_ / interval_ == before / interval_) return;
+    checkpoints_.push_back({ tick_, lvl.snapshot() });
+
+    // довгий прогін: проріджуємо знімки вдвічі й удвічі збільшуємо крок
+    if (checkpoints_.size() > 256) {
+        size_t kept = 0;
+        for (size_t i = 0; i < checkpoints_.size(); i += 2)
+            checkpoints_[kept++] = std::move(checkpoints_[i]);
+        checkpoints_.resize(kept);
+        interval_ *= 2;
+    }
+}
+
+void RunTrace::recordWorkers(const Level& lvl) {
+    auto record = [&](const std::vector<std::unique_ptr<Robot>>& arr) {
+        for (auto& r : arr) {
+            const RobotState* s = r->getState();
+            if (!s || !s->alive || s->type != RobotType::Worker) continue;
+
+            int dx = 0, dy = 0;
+            switch (s->dir) {
+                case Direction::Up:    dy = -1; break;
+                case Direction::Down:  dy = 1; break;
+                case Direction::Left:  dx = -1; break;
+                case Direction::Right: dx = 1; break;
+            }
+
+            // продовження прямого руху дописується у той самий відрізок
+            auto it = open_.find(s->id);
+            if (it != open_.end()) {
+                Segment& g = segments_[it->second];
+                int k = tick_ - (g.t0 + g.len);
+                if (k > 0 && g.dx == dx && g.dy == dy &&
+                    s->x == g.x0 + (g.len + k) * dx && s->y == g.y0 + (g.len + k) * dy) {
+                    g.len += k;
+                    continue;
+                }
+            }
+
+            open_[s->id] = segments_.size();
+            segments_.push_back({ s->id, tick_, s->x, s->y, dx, dy, 0 });
+        }
+    };
+    record(lvl.getRobots());
+    record(lvl.getPlacedRobots());
+}
+
+int RunTrace::firstNear(int x, int y) const {
+    const int cells[5][2] = { {x, y}, {x + 1, y}, {x - 1, y}, {x, y + 1}, {x, y - 1} };
+    int best = INT_MAX;
+
+    for (auto& g : segments_) {
+        for (auto& c : cells) {
+            int i;
+            if (g.dx != 0) {
+                if (c[1] != g.y0) continue;
+                i = (c[0] - g.x0) * g.dx;
+            } else {
+                if (c[0] != g.x0) continue;
+                i = (c[1] - g.y0) * g.dy;
+            }
+            if (i >= 0 && i <= g.len) best = std::min(best, g.t0 + i);
+        }
+    }
+    return best;
+}
+
+void RunTrace::noteEdit(int robotId, int tick) {
+    if (std::find(editedIds_.begin(), editedIds_.end(), robotId) == editedIds_.end())
+        editedIds_.push_back(robotId);
+    resumeLimit_ = std::min(resumeLimit_, tick);
+}
+
+const RunTrace::Checkpoint* RunTrace::resumePoint() const {
+    if (!valid_ || editedIds_.empty()) return nullptr;
+
+    const Checkpoint* best = nullptr;
+    for (auto& cp : checkpoints_) {
+        if (cp.tick > resumeLimit_) break;
+        best = &cp;
+    }
+    return best && best->tick > 0 ? best : nullptr;
+}
+
+const RunTrace::Checkpoint* RunTrace::rebase(const LevelSnapshot& placement) {
+    const Checkpoint* from = resumePoint();
+    if (!from) return nullptr;
+    const int t = from->tick;
+
+    while (!checkpoints_.empty() && checkpoints_.back().tick > t)
+        checkpoints_.pop_back();
+
+    // змінені роботи до ходу t ще ні з чим не взаємодіяли — їхній стан
+    // у знімках такий самий, як у новій розстановці
+    for (auto& cp : checkpoints_) {
+        for (size_t i = 0; i < placement.robots.size() && i < cp.snap.robots.size(); ++i) {
+            int id = placement.robots[i].state.id;
+            if (std::find(editedIds_.begin(), editedIds_.end(), id) != editedIds_.end())
+                cp.snap.robots[i] = placement.robots[i];
+        }
+    }
+
+    truncate(t);
+    editedIds_.clear();
+    resumeLimit_ = INT_MAX;
+    return &checkpoints_.back();
+}
+
+const RunTrace::Checkpoint* RunTrace::retreat() {
+    if (!checkpoints_.empty()) checkpoints_.pop_back();
+    if (checkpoints_.empty() || checkpoints_.back().tick == 0) {
+        clear();
+        return nullptr;
+    }
+
+    truncate(checkpoints_.back().tick);
+    return &checkpoints_.back();
+}
+
+void RunTrace::truncate(int t) {
+    segments_.erase(std::remove_if(segments_.begin(), segments_.end(),
+                                   [t](const Segment& g) { return g.t0 > t; }),
+                    segments_.end());
+    // відрізки, що доходять до ходу t, новий прогін продовжує
+    open_.clear();
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        Segment& g = segments_[i];
+        g.len = std::min(g.len, t - g.t0);
+        if (g.t0 + g.len == t) open_[g.id] = i;
+    }
+    tick_ = t;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <climits>
+#include <unordered_map>
+#include <vector>
+#include "Types.hpp"
+
+class Level;
+
+// Слід останнього прогону: знімки кожні interval ходів і шляхи робітників
+// відрізками прямого руху. Після правки розстановки за слідом видно, до
+// якого ходу новий прогін збігається зі старим, і його можна продовжити
+// з найближчого знімка, а не з нуля.
+// Копія (форк рушія) переймає лише інтервал, але не сам слід.
+class RunTrace {
+public:
+    struct Checkpoint {
+        int tick;
+        LevelSnapshot snap;
+    };
+
+    explicit RunTrace(int interval = 32) : interval_(interval) {}
+    RunTrace(const RunTrace& other) : interval_(other.interval_) {}
+    RunTrace& operator=(const RunTrace& other);
+    RunTrace(RunTrace&&) = default;
+    RunTrace& operator=(RunTrace&&) = default;
+
+    // 0 вимикає запис
+    void setInterval(int ticks);
+    int interval() const { return interval_; }
+
+    void clear();
+    bool valid() const { return valid_; }
+    int tick() const { return tick_; }
+    size_t checkpoints() const { return checkpoints_.size(); }
+
+    // старт прогону (хід 0) і стан після чергових ticks ходів
+    void begin(const Level& lvl);
+    void advance(int ticks, const Level& lvl);
+
+    // перший хід, на початку якого якийсь робітник стояв у клітинці (x, y)
+    // або поруч із нею; INT_MAX, якщо такого не було
+    int firstNear(int x, int y) const;
+
+    // робот robotId змінив розстановку; до ходу tick новий прогін
+    // збігається зі старим (tick = 0 — лише з нуля)
+    void noteEdit(int robotId, int tick);
+    bool edited() const { return !editedIds_.empty(); }
+
+    // найпізніший придатний знімок; nullptr, якщо правок не було або лише з нуля
+    const Checkpoint* resumePoint() const;
+
+    // продовження з resumePoint(): знімки до нього отримують змінених роботів
+    // із placement (стан на хід 0), решта сліду відкидається
+    const Checkpoint* rebase(const LevelSnapshot& placement);
+
+    // після rebase: відкинути останній знімок і продовжити з попереднього;
+    // nullptr (і слід очищено), якщо залишився лише старт
+    const Checkpoint* retreat();
+
+private:
+    struct Segment {
+        int id;
+        int t0;        // хід, з якого робітник у (x0, y0)
+        int x0, y0;
+        int dx, dy;
+        int len;       // на ході t0 + i робітник у (x0 + i*dx, y0 + i*dy), i <= len
+    };
+
+    int interval_;
+    bool valid_ = false;
+    int tick_ = 0;
+    std::vector<int> editedIds_;
+    int resumeLimit_ = INT_MAX;
+
+    std::vector<Checkpoint> checkpoints_;
+    std::vector<Segment> segments_;
+    std::unordered_map<int, size_t> open_;   // id робітника → його останній відрізок
+
+    void recordWorkers(const Level& lvl);
+    void truncate(int tick);
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+
+// Множина 64-бітних хешів станів одним плоским масивом (відкрита адресація,
+// лінійне зондування). Копія — одне виділення й memcpy, без вузлів
+// unordered_set, тож форк рушія посеред прогону копіює бачені стани дешево.
+// Хеші Zobrist уже випадкові, тож індекс — молодші біти; 0 — порожній слот,
+// сам хеш 0 тримається окремим прапорцем.
+class StateSet {
+public:
+    bool insert(uint64_t h) {
+        if (h == 0) {
+            if (hasZero_) return false;
+            hasZero_ = true;
+            ++size_;
+            return true;
+        }
+        if ((size_ + 1) * 2 > slots_.size()) grow();
+
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            if (slots_[i] == h) return false;
+            if (slots_[i] == 0) {
+                slots_[i] = h;
+                ++size_;
+                return true;
+            }
+        }
+    }
+
+    bool contains(uint64_t h) const {
+        if (h == 0) return hasZero_;
+        if (slots_.empty()) return false;
+
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            if (slots_[i] == h) return true;
+            if (slots_[i] == 0) return false;
+        }
+    }
+
+    // місце лишається виділеним: після reset прогін заповнить його знову
+    void clear() {
+        if (size_ > 0) std::fill(slots_.begin(), slots_.end(), 0);
+        hasZero_ = false;
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    template <typename F> void forEach(F&& f) const {
+        if (hasZero_) f(uint64_t{0});
+        for (uint64_t h : slots_)
+            if (h != 0) f(h);
+    }
+
+private:
+    std::vector<uint64_t> slots_;
+    size_t size_ = 0;
+    bool hasZero_ = false;
+
+    void grow() {
+        std::vector<uint64_t> old;
+        old.swap(slots_);
+        slots_.assign(old.empty() ? 64 : old.size() * 2, 0);
+
+        const size_t mask = slots_.size() - 1;
+        for (uint64_t h : old) {
+            if (h == 0) continue;
+            size_t i = h & mask;
+            while (slots_[i] != 0) i = (i + 1) & mask;
+            slots_[i] = h;
+        }
+    }
+};
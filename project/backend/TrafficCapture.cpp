@@ -0,0 +1,119 @@
+#include "TrafficCapture.hpp"
+#include "GameEngine.hpp"
+#include "RequestHandler.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+bool TrafficCapture::open(const std::string& path) {
+    out_.open(path, std::ios::trunc);
+    return out_.is_open();
+}
+
+void TrafficCapture::record(uint64_t tNs, uint64_t latencyNs, size_t responseBytes,
+                            const std::string& line)
+{
+    if (!out_.is_open()) return;
+    out_ << tNs << '\t' << latencyNs << '\t' << responseBytes << '\t' << line << '\n';
+}
+
+static double percentile(const std::vector<uint64_t>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    size_t i = (size_t)(q * (double)(sorted.size() - 1) + 0.5);
+    return (double)sorted[std::min(i, sorted.size() - 1)];
+}
+
+int runCaptureBench(const std::string& path, bool paced) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "Cannot read capture: " << path << std::endl;
+        return 1;
+    }
+
+    struct Item { uint64_t t; std::string line; };
+    std::vector<Item> items;
+
+    // обрізаний чи зіпсований рядок не зупиняє бенчмарк: він пропускається
+    // і рахується у звіті
+    size_t malformed = 0;
+    std::string row;
+    while (std::getline(in, row)) {
+        if (row.empty()) continue;
+
+        size_t a = row.find('\t');
+        size_t b = a == std::string::npos ? a : row.find('\t', a + 1);
+        size_t c = b == std::string::npos ? b : row.find('\t', b + 1);
+        if (c == std::string::npos) { ++malformed; continue; }
+
+        uint64_t t = 0;
+        auto [end, ec] = std::from_chars(row.data(), row.data() + a, t);
+        if (ec != std::errc() || end != row.data() + a) { ++malformed; continue; }
+
+        items.push_back(Item{ t, row.substr(c + 1) });
+    }
+    if (malformed > 0)
+        std::cerr << "Skipped " << malformed << " malformed capture rows" << std::endl;
+
+    GameEngine engine;
+    RequestHandler handler(engine);
+
+    std::map<std::string, std::vector<uint64_t>> latency;
+    uint64_t bytesOut = 0;
+
+    auto start = Clock::now();
+    for (auto& it : items) {
+        if (paced)
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(it.t));
+
+        auto t0 = Clock::now();
+        std::string action;
+        std::string out;
+        try {
+            json req = json::parse(it.line);
+            action = req.value("action", "");
+            out = handler.handle(req).dump();
+        } catch (const std::exception& e) {
+            out = json{{"status","error"},{"message", e.what()}}.dump();
+        }
+        auto t1 = Clock::now();
+
+        bytesOut += out.size() + 1;
+        latency[action.empty() ? "<invalid>" : action].push_back(
+            (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+    double sec = std::chrono::duration<double>(Clock::now() - start).count();
+
+    json report;
+    report["requests"] = items.size();
+    report["malformed_rows"] = malformed;
+    report["seconds"] = sec;
+    report["throughput_rps"] = sec > 0 ? items.size() / sec : 0.0;
+    report["bytes_out"] = bytesOut;
+    report["paced"] = paced;
+    report["actions"] = json::object();
+
+    for (auto& [action, v] : latency) {
+        std::sort(v.begin(), v.end());
+        uint64_t sum = 0;
+        for (auto x : v) sum += x;
+
+        report["actions"][action] = {
+            {"count", v.size()},
+            {"mean_us", sum / 1000.0 / v.size()},
+            {"p50_us",  percentile(v, 0.50) / 1000.0},
+            {"p99_us",  percentile(v, 0.99) / 1000.0},
+            {"p999_us", percentile(v, 0.999) / 1000.0},
+            {"max_us",  v.back() / 1000.0}
+        };
+    }
+
+    std::cout << report.dump(2) << std::endl;
+    return 0;
+}
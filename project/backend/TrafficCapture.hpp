@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Запис трафіку stdin/stdout: рядок на запит
+//   <t_ns>\t<latency_ns>\t<response_bytes>\t<сирий рядок запиту>
+// t_ns — час надходження від початку запису.
+class TrafficCapture {
+public:
+    bool open(const std::string& path);
+    bool isOpen() const { return out_.is_open(); }
+
+    void record(uint64_t tNs, uint64_t latencyNs, size_t responseBytes, const std::string& line);
+
+private:
+    std::ofstream out_;
+};
+
+// Прогін запису через RequestHandler: пропускна здатність і
+// p50/p99/p999 затримки на кожну дію. paced — з записаними інтервалами.
+int runCaptureBench(const std::string& path, bool paced);
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Таблиця результатів симуляції за хешем стану, спільна для потоків.
+// Запис — одне 64-бітне слово: старші 40 біт хешу | результат (2 біти) |
+// ходів до кінця (22 біти). Тому читання й запис без блокувань: слово
+// або ціле, або ще старе. Колізії за індексом просто перезаписують слот.
+class TranspositionTable {
+public:
+    enum Outcome : uint8_t { None = 0, Lose = 1, Win = 2 };
+
+    struct Entry {
+        Outcome outcome = None;
+        uint32_t ticksLeft = 0;
+    };
+
+    static constexpr uint32_t MaxTicks = (1u << 22) - 1;
+
+    explicit TranspositionTable(unsigned log2Slots = 20)
+        : mask_((size_t(1) << log2Slots) - 1),
+          slots_(new std::atomic<uint64_t>[size_t(1) << log2Slots])
+    {
+        for (size_t i = 0; i <= mask_; ++i)
+            slots_[i].store(0, std::memory_order_relaxed);
+    }
+
+    bool probe(uint64_t hash, Entry& out) const {
+        uint64_t w = slots_[hash & mask_].load(std::memory_order_relaxed);
+        if ((w >> 24) != (hash >> 24) || ((w >> 22) & 3) == None) return false;
+
+        out.outcome = (Outcome)((w >> 22) & 3);
+        out.ticksLeft = (uint32_t)(w & MaxTicks);
+        return true;
+    }
+
+    void store(uint64_t hash, Outcome outcome, uint32_t ticksLeft) {
+        if (outcome == None || ticksLeft > MaxTicks) return;
+        uint64_t w = (hash >> 24 << 24) | ((uint64_t)outcome << 22) | ticksLeft;
+        slots_[hash & mask_].store(w, std::memory_order_relaxed);
+    }
+
+    size_t slots() const { return mask_ + 1; }
+
+private:
+    size_t mask_;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
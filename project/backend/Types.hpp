@@ -3,6 +3,7 @@
 #include <optional>
 #include <memory>
 #include <string>
+#include <cstdint>
 
 enum class CellType { Empty, Wall, Target };
 enum class RobotType { Worker, Controller };
@@ -39,6 +40,23 @@ struct RobotState {
     
 };
 
+// Знімок динамічного стану одного робота
+struct RobotSnapshot {
+    RobotState state;
+    bool placed = false;      // робот зі списку placedRobots
+    bool listed = true;       // мертві роботи прибираються зі списків
+    bool hasCommand = false;  // незастосована команда контролера
+    Command command{};
+};
+
+// Динамічний шар рівня: роботи (у порядку id), коробки, лічильник ходів.
+// Рельєф сюди не входить.
+struct LevelSnapshot {
+    int moves = 0;
+    std::vector<RobotSnapshot> robots;
+    std::vector<Box> boxes;
+};
+
 // правильний WorldView
 struct WorldView {
     int width;
@@ -47,4 +65,21 @@ struct WorldView {
     const std::vector<std::vector<Cell>>* grid;
     std::vector<std::unique_ptr<RobotState>>* robotStates;
     std::vector<Box>* boxes;
+
+    // таблиця Level::getRayTable(); якщо її немає — перевірка за сіткою
+    const std::vector<uint16_t>* rays = nullptr;
+};
+
+// Площини спостереження: байт на клітинку (y*W + x), площини одна за одною.
+// Робітник іде в площину ObsWorkerUp + (int)dir.
+enum ObsChannel {
+    ObsWalls,
+    ObsTargets,
+    ObsBoxes,             // недоставлені, зокрема в руках
+    ObsWorkerUp,
+    ObsWorkerDown,
+    ObsWorkerLeft,
+    ObsWorkerRight,
+    ObsControllers,
+    ObsChannelCount
 };
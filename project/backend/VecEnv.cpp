@@ -0,0 +1,358 @@
+#include "VecEnv.hpp"
+#include "ControllerRobot.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+static const uint8_t toCw[4]  = { (uint8_t)Direction::Right, (uint8_t)Direction::Left,
+                                  (uint8_t)Direction::Up,    (uint8_t)Direction::Down };
+static const uint8_t toCcw[4] = { (uint8_t)Direction::Left,  (uint8_t)Direction::Right,
+                                  (uint8_t)Direction::Down,  (uint8_t)Direction::Up };
+
+VecEnv::VecEnv(int count, VecEnvOptions opt) : count_(std::max(0, count)), opt_(opt) {}
+
+bool VecEnv::load(const GameEngine& tmpl) {
+    const Level& lvl = tmpl.getLevel();
+    width_ = lvl.getWidth();
+    height_ = lvl.getHeight();
+    cells_ = width_ * height_;
+    step_[(int)Direction::Up] = -width_;
+    step_[(int)Direction::Down] = width_;
+    step_[(int)Direction::Left] = -1;
+    step_[(int)Direction::Right] = 1;
+
+    canMove_.assign((size_t)cells_ * 4, 0);
+    target_.assign(cells_, 0);
+    component_.assign(cells_, -1);
+    staticObs_.assign((size_t)cells_ * 2, 0);
+    for (int c = 0; c < cells_; ++c) {
+        int x = c % width_, y = c / width_;
+        for (int d = 0; d < 4; ++d) canMove_[(size_t)c * 4 + d] = lvl.rayDistance(x, y, (Direction)d) > 0;
+        target_[c] = lvl.isTarget(x, y);
+        // до цілей не дійти — як і без робітника поруч, для безнадійності це одне
+        component_[c] = lvl.targetDistance(x, y) >= 0 ? lvl.componentAt(x, y) : -1;
+        staticObs_[(size_t)ObsWalls * cells_ + c] = lvl.isWall(x, y);
+        staticObs_[(size_t)ObsTargets * cells_ + c] = target_[c];
+    }
+
+    const auto& boxes = lvl.getBoxes();
+    boxSlots_ = (int)boxes.size();
+    initBoxCell_.assign(boxSlots_, 0);
+    initBoxState_.assign(boxSlots_, Loose);
+    for (int b = 0; b < boxSlots_; ++b) {
+        if (!lvl.isInside(boxes[b].x, boxes[b].y)) return false;
+        initBoxCell_[b] = boxes[b].y * width_ + boxes[b].x;
+        if (boxes[b].delivered) initBoxState_[b] = Delivered;
+    }
+
+    isWorker_.clear(); initCell_.clear(); initDir_.clear(); initMark_.clear();
+    initCmd_.clear(); initCarry_.clear(); workerSlot_.clear();
+    std::vector<int> cmdIds;
+    std::vector<uint8_t> taken(cells_, 0);
+    std::unordered_map<int, int> slotOf;   // id → слот
+
+    auto collect = [&](const std::vector<std::unique_ptr<Robot>>& arr) {
+        for (auto& r : arr) {
+            const RobotState* s = r->getState();
+            if (!s || !lvl.isInside(s->x, s->y) || lvl.isWall(s->x, s->y)) return false;
+            int c = s->y * width_ + s->x;
+            if (taken[c]) return false;
+            taken[c] = 1;
+
+            int8_t cmd = -1;
+            int cmdId = 0;
+            if (auto* ctrl = dynamic_cast<const ControllerRobot*>(r.get())) {
+                if (ctrl->hasPendingCommand()) {
+                    auto& pc = *ctrl->getPendingCommand();
+                    if (pc.type != CommandType::RotateCW && pc.type != CommandType::RotateCCW) return false;
+                    cmd = (int8_t)pc.type;
+                    cmdId = pc.robotId;
+                }
+            }
+
+            int carry = -1;
+            if (s->carrying) {
+                if (!s->boxId) return false;
+                for (int b = 0; b < boxSlots_; ++b)
+                    if (boxes[b].id == *s->boxId) { carry = b; break; }
+                if (carry < 0 || initBoxState_[carry] != Loose) return false;
+                initBoxState_[carry] = Carried;
+            } else if (s->boxId) {
+                return false;
+            }
+
+            int slot = (int)isWorker_.size();
+            slotOf.emplace(s->id, slot);
+            if (s->type == RobotType::Worker) workerSlot_.push_back(slot);
+            isWorker_.push_back(s->type == RobotType::Worker);
+            initCell_.push_back(c);
+            initDir_.push_back((uint8_t)s->dir);
+            initMark_.push_back(s->alive ? Alive : Dead);
+            initCmd_.push_back(cmd);
+            initCarry_.push_back(carry);
+            cmdIds.push_back(cmdId);
+        }
+        return true;
+    };
+    if (!collect(lvl.getRobots()) || !collect(lvl.getPlacedRobots())) return false;
+
+    // контролер, що повертає контролера, крутить робота за id зі своєї команди
+    cmdTarget_.assign(isWorker_.size(), -1);
+    for (size_t s = 0; s < cmdIds.size(); ++s) {
+        auto it = slotOf.find(cmdIds[s]);
+        if (initCmd_[s] >= 0 && it != slotOf.end()) cmdTarget_[s] = it->second;
+    }
+
+    // випадкові робітники — в кінці порядку ходу, поки reset їх не поставить
+    for (int k = 0; k < std::max(0, opt_.randomWorkers); ++k) {
+        workerSlot_.push_back((int)isWorker_.size());
+        isWorker_.push_back(1);
+        initCell_.push_back(0);
+        initDir_.push_back((uint8_t)Direction::Up);
+        initMark_.push_back(Gone);
+        initCmd_.push_back(-1);
+        initCarry_.push_back(-1);
+        cmdTarget_.push_back(-1);
+    }
+    robotSlots_ = (int)isWorker_.size();
+    workerSlots_ = (int)workerSlot_.size();
+    if (robotSlots_ > INT16_MAX) return false;
+
+    const size_t R = robotSlots_, B = boxSlots_, N = count_;
+    cell_.assign(N * R, 0);
+    dir_.assign(N * R, 0);
+    mark_.assign(N * R, Gone);
+    cmd_.assign(N * R, -1);
+    carry_.assign(N * R, -1);
+    boxCell_.assign(N * B, 0);
+    boxState_.assign(N * B, Delivered);
+    occ_.assign(N * cells_, -1);
+    loose_.assign(N * cells_, 0);
+    undelivered_.assign(N, 0);
+
+    obs_.assign(N * ObsChannelCount * cells_, 0);
+    reward_.assign(N, 0.0f);
+    done_.assign(N, 0);
+    outcome_.assign(N, Running);
+    ticks_.assign(N, 0);
+
+    for (int e = 0; e < count_; ++e) resetOne(e, 0);
+    return true;
+}
+
+void VecEnv::reset(const std::vector<uint64_t>& seeds) {
+    for (int e = 0; e < count_ && e < (int)seeds.size(); ++e) resetOne(e, seeds[e]);
+}
+
+void VecEnv::resetOne(int env, uint64_t seed) {
+    if (env < 0 || env >= count_) return;
+    const size_t R = robotSlots_, B = boxSlots_;
+    const size_t rb = env * R, bb = env * B, cb = (size_t)env * cells_;
+
+    std::copy(initCell_.begin(), initCell_.end(), cell_.begin() + rb);
+    std::copy(initDir_.begin(), initDir_.end(), dir_.begin() + rb);
+    std::copy(initMark_.begin(), initMark_.end(), mark_.begin() + rb);
+    std::copy(initCmd_.begin(), initCmd_.end(), cmd_.begin() + rb);
+    std::copy(initCarry_.begin(), initCarry_.end(), carry_.begin() + rb);
+    std::copy(initBoxCell_.begin(), initBoxCell_.end(), boxCell_.begin() + bb);
+    std::copy(initBoxState_.begin(), initBoxState_.end(), boxState_.begin() + bb);
+
+    int16_t* occ = &occ_[cb];
+    uint8_t* loose = &loose_[cb];
+    std::fill(occ, occ + cells_, -1);
+    std::fill(loose, loose + cells_, 0);
+
+    for (size_t s = 0; s < R; ++s)
+        if (mark_[rb + s] != Gone) occ[cell_[rb + s]] = (int16_t)s;
+    int undelivered = 0;
+    for (size_t b = 0; b < B; ++b) {
+        if (boxState_[bb + b] == Delivered) continue;
+        ++undelivered;
+        if (boxState_[bb + b] == Loose) ++loose[boxCell_[bb + b]];
+    }
+    undelivered_[env] = undelivered;
+
+    // випадкові робітники: порожні клітинки без стін, цілей і коробок
+    if (opt_.randomWorkers > 0) {
+        std::vector<int> free;
+        for (int c = 0; c < cells_; ++c)
+            if (occ[c] < 0 && !loose[c] && !target_[c] && !staticObs_[(size_t)ObsWalls * cells_ + c])
+                free.push_back(c);
+
+        std::mt19937_64 rng(seed);
+        size_t placed = 0;
+        for (size_t s = R - opt_.randomWorkers; s < R && placed < free.size(); ++s, ++placed) {
+            std::swap(free[placed], free[placed + rng() % (free.size() - placed)]);
+            cell_[rb + s] = free[placed];
+            dir_[rb + s] = (uint8_t)(rng() % 4);
+            mark_[rb + s] = Alive;
+            occ[free[placed]] = (int16_t)s;
+        }
+    }
+
+    ticks_[env] = 0;
+    reward_[env] = 0.0f;
+    outcome_[env] = undelivered == 0 ? Won : Running;
+    done_[env] = outcome_[env] != Running;
+    observe(env);
+}
+
+void VecEnv::step(const std::vector<int32_t>& actions) {
+    for (int e = 0; e < count_; ++e) {
+        if (done_[e]) {
+            reward_[e] = 0.0f;
+            continue;
+        }
+        tick(e, e < (int)actions.size() ? actions[e] : 0);
+    }
+}
+
+// хід однієї копії — як GameEngine::stepAuto
+void VecEnv::tick(int env, int32_t action) {
+    const int R = robotSlots_;
+    int32_t* cell = &cell_[(size_t)env * R];
+    uint8_t* dir = &dir_[(size_t)env * R];
+    uint8_t* mark = &mark_[(size_t)env * R];
+    int8_t* cmd = &cmd_[(size_t)env * R];
+    int32_t* carry = &carry_[(size_t)env * R];
+    int32_t* boxCell = &boxCell_[(size_t)env * boxSlots_];
+    uint8_t* boxState = &boxState_[(size_t)env * boxSlots_];
+    int16_t* occ = &occ_[(size_t)env * cells_];
+    uint8_t* loose = &loose_[(size_t)env * cells_];
+
+    float reward = opt_.stepReward;
+
+    // ===== ДІЯ АГЕНТА =====
+    if (action > 0 && (action - 1) / 2 < workerSlots_) {
+        int s = workerSlot_[(action - 1) / 2];
+        if (mark[s] == Alive) dir[s] = (action - 1) % 2 == 0 ? toCw[dir[s]] : toCcw[dir[s]];
+    }
+
+    // ===== КОНТРОЛЕРИ =====
+    for (int s = 0; s < R; ++s) {
+        if (isWorker_[s] || mark[s] == Gone || cmd[s] < 0) continue;
+
+        int x = cell[s] % width_ + (dir[s] == (uint8_t)Direction::Right) - (dir[s] == (uint8_t)Direction::Left);
+        int y = cell[s] / width_ + (dir[s] == (uint8_t)Direction::Down) - (dir[s] == (uint8_t)Direction::Up);
+        if (x < 0 || y < 0 || x >= width_ || y >= height_) continue;
+        int j = occ[y * width_ + x];
+        if (j < 0) continue;
+
+        bool cw = cmd[s] == (int8_t)CommandType::RotateCW;
+        cmd[s] = -1;
+        if (mark[j] != Alive) continue;
+
+        int t = isWorker_[j] ? j : cmdTarget_[s];
+        if (t >= 0 && mark[t] == Alive) dir[t] = cw ? toCw[dir[t]] : toCcw[dir[t]];
+    }
+
+    // ===== РУХ WORKER =====
+    for (int s = 0; s < R; ++s) {
+        if (!isWorker_[s] || mark[s] != Alive) continue;
+
+        int c = cell[s];
+        int n = c + step_[dir[s]];
+        if (!canMove_[(size_t)c * 4 + dir[s]] || occ[n] >= 0) {
+            mark[s] = Dead;
+            continue;
+        }
+
+        occ[c] = -1;
+        occ[n] = (int16_t)s;
+        cell[s] = n;
+
+        if (carry[s] < 0 && loose[n]) {
+            for (int b = 0; b < boxSlots_; ++b) {
+                if (boxState[b] == Loose && boxCell[b] == n) {
+                    boxState[b] = Carried;
+                    --loose[n];
+                    carry[s] = b;
+                    break;
+                }
+            }
+        }
+
+        if (carry[s] >= 0) {
+            boxCell[carry[s]] = n;
+            if (target_[n]) {
+                boxState[carry[s]] = Delivered;
+                carry[s] = -1;
+                --undelivered_[env];
+                reward += opt_.deliverReward;
+            }
+        }
+    }
+
+    // ===== ВИДАЛЕННЯ МЕРТВИХ: вантаж лишається в клітинці =====
+    for (int s = 0; s < R; ++s) {
+        if (mark[s] != Dead) continue;
+        mark[s] = Gone;
+        occ[cell[s]] = -1;
+        if (carry[s] >= 0) {
+            boxState[carry[s]] = Loose;
+            ++loose[cell[s]];
+            carry[s] = -1;
+        }
+    }
+
+    ++ticks_[env];
+    reward_[env] = reward;
+    finishTick(env);
+    observe(env);
+}
+
+// Агент повертає робітників будь-коли, тож, як у GameEngine після ручних
+// команд, коробка безнадійна, лише коли від неї не дійти до цілі або в її
+// області немає живого робітника.
+bool VecEnv::hopeless(int env) const {
+    const size_t rb = (size_t)env * robotSlots_, bb = (size_t)env * boxSlots_;
+    for (int b = 0; b < boxSlots_; ++b) {
+        if (boxState_[bb + b] == Delivered) continue;
+        int comp = component_[boxCell_[bb + b]];
+        if (comp < 0) return true;
+
+        bool reachable = false;
+        for (int k = 0; k < workerSlots_ && !reachable; ++k) {
+            size_t s = rb + workerSlot_[k];
+            reachable = mark_[s] == Alive && component_[cell_[s]] == comp;
+        }
+        if (!reachable) return true;
+    }
+    return false;
+}
+
+void VecEnv::finishTick(int env) {
+    const size_t rb = (size_t)env * robotSlots_;
+    bool anyWorker = false;
+    for (int k = 0; k < workerSlots_ && !anyWorker; ++k) anyWorker = mark_[rb + workerSlot_[k]] == Alive;
+
+    if (undelivered_[env] == 0) {
+        outcome_[env] = Won;
+        reward_[env] += opt_.winReward;
+    } else if (!anyWorker || (opt_.earlyLose && hopeless(env))) {
+        outcome_[env] = Lost;
+        reward_[env] += opt_.loseReward;
+    } else if (ticks_[env] >= opt_.maxTicks) {
+        outcome_[env] = Truncated;
+    }
+    done_[env] = outcome_[env] != Running;
+}
+
+void VecEnv::observe(int env) {
+    const size_t plane = cells_;
+    uint8_t* o = &obs_[(size_t)env * ObsChannelCount * plane];
+    std::memcpy(o, staticObs_.data(), 2 * plane);
+    std::memset(o + 2 * plane, 0, (ObsChannelCount - 2) * plane);
+
+    const size_t rb = (size_t)env * robotSlots_, bb = (size_t)env * boxSlots_;
+    for (int b = 0; b < boxSlots_; ++b)
+        if (boxState_[bb + b] != Delivered) o[ObsBoxes * plane + boxCell_[bb + b]] = 1;
+    for (int s = 0; s < robotSlots_; ++s) {
+        if (mark_[rb + s] != Alive) continue;
+        int ch = isWorker_[s] ? ObsWorkerUp + dir_[rb + s] : ObsControllers;
+        o[ch * plane + cell_[rb + s]] = 1;
+    }
+}
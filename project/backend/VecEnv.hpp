@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "GameEngine.hpp"
+
+struct VecEnvOptions {
+    int randomWorkers = 0;        // скільки робітників reset кидає у випадкові вільні клітинки
+    int maxTicks = 200;           // далі епізод обрізається
+    bool earlyLose = true;        // безнадійний стан — поразка, як у GameEngine
+    float deliverReward = 1.0f;   // за кожну здану коробку
+    float winReward = 1.0f;
+    float loseReward = -1.0f;
+    float stepReward = 0.0f;      // за кожен хід
+};
+
+// Багато незалежних копій одного рівня, що ходять разом. Стан усіх копій
+// лежить масивами по полях (клітинка, напрямок, вантаж... робота r копії
+// e — за індексом e*R + r), тож step — один прохід по суцільній пам'яті
+// без JSON і віртуальних викликів. Хід той самий, що GameEngine::stepAuto:
+// контролери, робітники в порядку списків, прибирання мертвих. Перед ним
+// агент копії може повернути одного свого робітника — як ручна команда
+// повороту. Дія: 0 — нічого, 1 + 2k — робітник k за годинниковою, 2 + 2k —
+// проти; k рахує робітників рівня в порядку списків, потім випадкових.
+// Не підтримуються роботи поза картою чи в стіні, два роботи в одній
+// клітинці і команди контролерів, крім поворотів, — тоді load повертає false.
+class VecEnv {
+public:
+    enum Outcome : uint8_t { Running, Won, Lost, Truncated };
+
+    explicit VecEnv(int count, VecEnvOptions opt = {});
+
+    // шаблон для всіх копій: рельєф, коробки й роботи (разом із розставленими)
+    bool load(const GameEngine& tmpl);
+
+    int size() const { return count_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int actionCount() const { return 1 + 2 * workerSlots_; }
+
+    // seeds[e] задає випадкових робітників копії e; seeds.size() == size()
+    void reset(const std::vector<uint64_t>& seeds);
+    void resetOne(int env, uint64_t seed);
+
+    // actions[e] для кожної копії; завершені копії стоять із нульовою нагородою
+    void step(const std::vector<int32_t>& actions);
+
+    // size() × ObsChannelCount × height × width, стан після останнього reset/step
+    const std::vector<uint8_t>& observations() const { return obs_; }
+    const std::vector<float>& rewards() const { return reward_; }
+    const std::vector<uint8_t>& dones() const { return done_; }
+    const std::vector<uint8_t>& outcomes() const { return outcome_; }
+    const std::vector<int32_t>& ticks() const { return ticks_; }
+
+private:
+    enum RobotMark : uint8_t { Gone, Alive, Dead };   // Dead — ще в списку до кінця ходу
+
+    int count_;
+    VecEnvOptions opt_;
+    int width_ = 0, height_ = 0, cells_ = 0;
+    int step_[4] = {};
+
+    // рельєф, спільний для всіх копій
+    std::vector<uint8_t> canMove_;     // cell*4 + Direction: сусід не стіна і не край
+    std::vector<uint8_t> target_;
+    std::vector<int32_t> component_;   // див. Level::componentAt
+    std::vector<uint8_t> staticObs_;   // площини стін і цілей
+
+    // шаблон: R слотів роботів у порядку ходу, B коробок
+    int robotSlots_ = 0, workerSlots_ = 0, boxSlots_ = 0;
+    std::vector<uint8_t> isWorker_;    // [R]
+    std::vector<int32_t> workerSlot_;  // [робітник k] → слот
+    std::vector<int32_t> cmdTarget_;   // [R] слот робота з id команди контролера, -1 — немає
+    std::vector<int32_t> initCell_;
+    std::vector<uint8_t> initDir_, initMark_;
+    std::vector<int8_t> initCmd_;
+    std::vector<int32_t> initCarry_;
+    std::vector<int32_t> initBoxCell_;
+    std::vector<uint8_t> initBoxState_;
+
+    // стан копій: [e*R + r], [e*B + b], [e*cells + c], [e]
+    std::vector<int32_t> cell_;
+    std::vector<uint8_t> dir_, mark_;
+    std::vector<int8_t> cmd_;          // CommandType, -1 — немає
+    std::vector<int32_t> carry_;       // номер коробки, -1 — без вантажу
+    enum BoxState : uint8_t { Loose, Carried, Delivered };
+    std::vector<int32_t> boxCell_;
+    std::vector<uint8_t> boxState_;
+    std::vector<int16_t> occ_;         // клітинка → слот робота, -1 — порожньо
+    std::vector<uint8_t> loose_;       // скільки вільних коробок у клітинці
+    std::vector<int32_t> undelivered_;
+
+    std::vector<uint8_t> obs_;
+    std::vector<float> reward_;
+    std::vector<uint8_t> done_, outcome_;
+    std::vector<int32_t> ticks_;
+
+    void tick(int env, int32_t action);
+    bool hopeless(int env) const;
+    void finishTick(int env);
+    void observe(int env);
+};
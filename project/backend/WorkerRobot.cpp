@@ -38,23 +38,22 @@ void WorkerRobot::execute(const Command& cmd, WorldView& w)
             // Оновлюємо напрямок для правильних стрілок
             st->dir = cmd.dir;
 
-            // 1) Вихід за межі → робот зникає
-            if (nx < 0 || ny < 0 || nx >= w.width || ny >= w.height) {
+            // 1) Вихід за межі або вхід у стіну → робот зникає
+            bool blocked;
+            if (w.rays && inBounds(st->x, st->y, w.width, w.height))
+                blocked = (*w.rays)[((size_t)st->y * w.width + st->x) * 4 + (size_t)cmd.dir] == 0;
+            else
+                blocked = !inBounds(nx, ny, w.width, w.height) ||
+                          (*w.grid)[ny][nx].type == CellType::Wall;
+
+            if (blocked) {
                 st->alive = false;
                 st->carrying = false;
                 st->boxId.reset();
                 return;
             }
 
-            // 2) Вхід у стіну → робот зникає
-            if ((*w.grid)[ny][nx].type == CellType::Wall) {
-                st->alive = false;
-                st->carrying = false;
-                st->boxId.reset();
-                return;
-            }
-
-            // 3) Переносимо коробку, якщо робочий її несе
+            // 2) Переносимо коробку, якщо робочий її несе
             if (st->carrying && st->boxId) {
                 for (auto& b : *w.boxes) {
                     if (b.id == *st->boxId) {
@@ -65,7 +64,7 @@ void WorkerRobot::execute(const Command& cmd, WorldView& w)
                 }
             }
 
-            // 4) Робітник рухається
+            // 3) Робітник рухається
             st->x = nx;
             st->y = ny;
             break;
@@ -5,5 +5,6 @@ class WorkerRobot : public Robot {
 public:
     WorkerRobot() = default;
     RobotType getType() const override { return RobotType::Worker; }
+    std::unique_ptr<Robot> clone() const override { return std::make_unique<WorkerRobot>(*this); }
     void execute(const Command& cmd, WorldView& world) override;
 };
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "GameEngine.hpp"
+#include "LevelGenerator.hpp"
+#include "LevelLoader.hpp"
+#include "RequestHandler.hpp"
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+// oop_bench [--sizes 10,100,1000,4000] [--robots 1,16,256] [--boxes 1,16,256]
+//           [--walls 0.1,0.3] [--count-size 100] [--filter name] [--min-ms 50]
+//           [--out results.json] [--baseline base.json] [--tolerance 0.2]
+//
+// Спершу розмір карти (сторона зі --sizes, решта — типові кількості), потім
+// на карті --count-size кожна з кількостей роботів, коробок і частка стін
+// окремо. Рівні — з LevelGenerator із seed 1, тож однакові між запусками.
+// З --baseline кожен замір порівнюється з тим самим у файлі; повільніше
+// більш ніж на tolerance — регресія, код виходу 4.
+
+struct Case {
+    int side = 10;
+    int robots = 4;
+    int boxes = 4;
+    double walls = 0.2;
+};
+
+struct Sample {
+    double nsPerOp = 0;
+    uint64_t ops = 0;
+};
+
+static double minMs = 50;
+static constexpr int Rounds = 5;
+
+static double median(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+// чисті або стаціонарні дії: партія подвоюється, поки не займе minMs / Rounds,
+// тоді Rounds таких партій і медіана — одиничні паузи ОС не зсувають результат
+static Sample measureBatch(const std::function<void()>& op) {
+    auto batch = [&](uint64_t n) {
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < n; ++i) op();
+        return std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    };
+
+    uint64_t n = 1;
+    double first = batch(n);
+    while (first < minMs * 1e6 / Rounds && n < (1ull << 30)) first = batch(n *= 2);
+
+    std::vector<double> perOp{ first / n };
+    for (int r = 1; r < Rounds; ++r) perOp.push_back(batch(n) / n);
+    return Sample{ median(perOp), n * Rounds };
+}
+
+// дії, що ведуть гру до кінця: кожна міряється окремо, reset — поза заміром;
+// медіана, бо перший виклик після reset часто будує кеші
+static Sample measureEach(const std::function<void()>& op,
+                          const std::function<bool()>& finished,
+                          const std::function<void()>& reset) {
+    std::vector<double> perOp;
+    auto started = Clock::now();
+    do {
+        if (finished()) reset();
+        auto t0 = Clock::now();
+        op();
+        perOp.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+    } while ((std::chrono::duration<double, std::milli>(Clock::now() - started).count() < minMs
+              || perOp.size() < Rounds) && perOp.size() < (1u << 24));
+    return Sample{ median(perOp), perOp.size() };
+}
+
+// число з аргументу цілком, без знаку для беззнакових типів
+template <class T>
+static bool parseNumber(const char* s, T& out) {
+    const char* end = s + std::char_traits<char>::length(s);
+    auto [p, ec] = std::from_chars(s, end, out);
+    return ec == std::errc() && p == end && p != s;
+}
+
+static int invalidValue(const std::string& option, const char* value) {
+    std::cerr << "Invalid value for " << option << ": " << value << std::endl;
+    return 2;
+}
+
+static bool parseList(const std::string& s, std::vector<double>& out) {
+    out.clear();
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) {
+            double v;
+            if (!parseNumber(item.c_str(), v)) return false;
+            out.push_back(v);
+        }
+    return true;
+}
+
+static std::string keyOf(const json& r) {
+    return r["name"].get<std::string>() + "/" + std::to_string(r["width"].get<int>()) + "x" +
+           std::to_string(r["height"].get<int>()) + "/r" + std::to_string(r["robots"].get<int>()) +
+           "/b" + std::to_string(r["boxes"].get<int>()) + "/w" + std::to_string(r["walls"].get<double>());
+}
+
+static void runCase(const Case& c, const std::string& filter, json& results) {
+    LevelGenOptions opt;
+    opt.width = opt.height = c.side;
+    opt.wallDensity = c.walls;
+    opt.boxes = opt.targets = c.boxes;
+    opt.workers = c.robots;
+    auto generated = LevelGenerator(opt).generate(1);
+    if (!generated) {
+        std::clog << "skip " << c.side << "x" << c.side << ": level does not fit" << std::endl;
+        return;
+    }
+
+    const std::string text = LevelGenerator::levelToJson(*generated).dump();
+    const std::string path = (std::filesystem::temp_directory_path() /
+                              ("oop_bench_" + std::to_string(c.side) + ".json")).string();
+    std::ofstream(path) << text;
+
+    GameEngine eng;
+    RequestHandler handler(eng);
+    handler.handle(json{{"action", "load_level"}, {"path", path}});
+
+    std::vector<int> workerIds;
+    for (auto& r : eng.getLevel().getRobots())
+        if (r->getState() && r->getState()->type == RobotType::Worker) workerIds.push_back(r->getState()->id);
+
+    auto record = [&](const std::string& name, const Sample& s) {
+        json r = {
+            {"name", name},
+            {"width", c.side}, {"height", c.side}, {"cells", (long)c.side * c.side},
+            {"robots", c.robots}, {"boxes", c.boxes}, {"walls", c.walls},
+            {"ns_per_op", s.nsPerOp}, {"ops", s.ops}
+        };
+        std::clog << keyOf(r) << "  " << s.nsPerOp << " ns" << std::endl;
+        results.push_back(r);
+    };
+    auto wanted = [&](const std::string& name) { return filter.empty() || name.find(filter) != std::string::npos; };
+    auto reset = [&]() { eng.reset(); };
+    auto finished = [&]() { return eng.isFinished(); };
+
+    if (wanted("level_update")) {
+        Level& lvl = eng.getLevelMutable();
+        record("level_update", measureBatch([&] { lvl.update(); }));
+        eng.reset();
+    }
+    if (wanted("step_auto"))
+        record("step_auto", measureEach([&] { eng.stepAuto(); }, finished, reset));
+    if (wanted("apply_commands")) {
+        std::vector<Command> cmds;
+        for (int id : workerIds) cmds.push_back(Command{ id, CommandType::RotateCW, Direction::Up });
+        record("apply_commands", measureBatch([&] { eng.applyCommands(cmds); }));
+        eng.reset();
+    }
+    if (wanted("clone")) {
+        record("clone", measureBatch([&] { auto fork = eng.clone(); }));
+        // посеред прогону форк несе й seen_ — плоский масив хешів прогону
+        for (int t = 0; t < 64 && !eng.isFinished(); ++t) eng.stepAuto();
+        record("clone/running", measureBatch([&] { auto fork = eng.clone(); }));
+        eng.reset();
+    }
+    if (wanted("get_state_json"))
+        record("get_state_json", measureBatch([&] { auto st = eng.getStateJson(); }));
+    if (wanted("load_from_json"))
+        record("load_from_json", measureBatch([&] { auto l = LevelLoader::loadFromJsonText(text.data(), text.size()); }));
+
+    // RequestHandler::handle по діях; запит розібраний заздалегідь
+    json commands = json::array();
+    for (int id : workerIds) commands.push_back({{"robot_id", id}, {"cmd", "rotate_cw"}});
+    const int far = c.side - 1;
+    const std::vector<std::pair<std::string, json>> requests = {
+        { "status",      json{{"action", "status"}} },
+        { "ray_query",   json{{"action", "ray_query"}, {"x", far / 2}, {"y", far / 2}} },
+        { "path",        json{{"action", "path"}, {"from", {{"x", 0}, {"y", 0}}}, {"to", {{"x", far}, {"y", far}}}} },
+        { "flow_steer",  json{{"action", "flow_steer"}} },
+        { "step",        json{{"action", "step"}, {"commands", commands}} },
+        { "load_level",  json{{"action", "load_level"}, {"path", path}} },
+    };
+    for (auto& [action, req] : requests) {
+        if (!wanted("handle/" + action)) continue;
+        record("handle/" + action, measureBatch([&] { auto r = handler.handle(req); }));
+        eng.reset();
+    }
+    if (wanted("handle/run_step")) {
+        const json req = {{"action", "run_step"}};
+        record("handle/run_step", measureEach([&] { auto r = handler.handle(req); }, finished, reset));
+    }
+
+    std::remove(path.c_str());
+}
+
+int main(int argc, char** argv) {
+    std::vector<double> sizes = { 10, 32, 100, 316, 1000, 4000 };
+    std::vector<double> robots = { 1, 16, 256 }, boxes = { 1, 16, 256 }, walls = { 0.0, 0.1, 0.3 };
+    int countSide = 100;
+    std::string filter, outPath, baselinePath;
+    double tolerance = 0.2;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--sizes" && i + 1 < argc) {
+            if (!parseList(argv[++i], sizes)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--robots" && i + 1 < argc) {
+            if (!parseList(argv[++i], robots)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--boxes" && i + 1 < argc) {
+            if (!parseList(argv[++i], boxes)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--walls" && i + 1 < argc) {
+            if (!parseList(argv[++i], walls)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--count-size" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], countSide)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--min-ms" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], minMs)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], tolerance)) return invalidValue(arg, argv[i]);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+#ifndef NDEBUG
+    std::clog << "warning: built without NDEBUG, configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+
+    // обробник пише журнал у std::cerr; прогрес іде в std::clog
+    auto* cerrBuf = std::cerr.rdbuf(nullptr);
+    json results = json::array();
+    for (double s : sizes) runCase(Case{ (int)s }, filter, results);
+    for (double r : robots) runCase(Case{ countSide, (int)r }, filter, results);
+    for (double b : boxes) runCase(Case{ countSide, Case{}.robots, (int)b }, filter, results);
+    for (double w : walls) runCase(Case{ countSide, Case{}.robots, Case{}.boxes, w }, filter, results);
+    std::cerr.rdbuf(cerrBuf);
+    std::cerr.clear();
+
+    json report = {
+        {"min_ms", minMs},
+#ifdef NDEBUG
+        {"optimized", true},
+#else
+        {"optimized", false},
+#endif
+        {"results", results}
+    };
+
+    int code = 0;
+    if (!baselinePath.empty()) {
+        std::ifstream in(baselinePath);
+        json base;
+        try { in >> base; }
+        catch (...) {
+            std::cerr << "Cannot read baseline: " << baselinePath << std::endl;
+            return 1;
+        }
+
+        std::map<std::string, double> before;
+        for (auto& r : base.value("results", json::array())) before[keyOf(r)] = r["ns_per_op"].get<double>();
+
+        json regressions = json::array();
+        int compared = 0;
+        for (auto& r : results) {
+            auto it = before.find(keyOf(r));
+            if (it == before.end() || it->second <= 0) continue;
+            ++compared;
+            double ratio = r["ns_per_op"].get<double>() / it->second;
+            if (ratio > 1 + tolerance)
+                regressions.push_back({{"key", keyOf(r)}, {"ns_per_op", r["ns_per_op"]},
+                                       {"baseline_ns_per_op", it->second}, {"ratio", ratio}});
+        }
+        report["baseline"] = {
+            {"path", baselinePath}, {"tolerance", tolerance},
+            {"compared", compared}, {"regressions", regressions}
+        };
+        if (!regressions.empty()) code = 4;
+    }
+
+    if (!outPath.empty()) std::ofstream(outPath) << report.dump(2) << '\n';
+    std::cout << report.dump(2) << std::endl;
+    return code;
+}
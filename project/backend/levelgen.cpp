@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "LevelGenerator.hpp"
+#include "LevelBinary.hpp"
+
+using json = nlohmann::json;
+
+// число з аргументу цілком, без знаку для беззнакових типів
+template <class T>
+static bool parseNumber(const char* s, T& out) {
+    const char* end = s + std::char_traits<char>::length(s);
+    auto [p, ec] = std::from_chars(s, end, out);
+    return ec == std::errc() && p == end && p != s;
+}
+
+static int invalidValue(const std::string& option, const char* value) {
+    std::cerr << "Invalid value for " << option << ": " << value << std::endl;
+    return 2;
+}
+
+// oop_levelgen --out dir [--count N] [--seed S] [--width W] [--height H]
+//              [--walls 0.2] [--boxes N] [--targets N] [--workers N]
+//              [--controllers N] [--reachable] [--binary] [--threads N]
+// Рівень i пишеться в dir/level_<seed + i>.json (.lvlb з --binary) і
+// залежить лише від свого seed, тож кількість потоків на результат не впливає.
+int main(int argc, char** argv) {
+    LevelGenOptions opt;
+    std::string outDir;
+    uint64_t seed = 1;
+    long count = 1;
+    int threads = 0;
+    bool binary = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--out" && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (arg == "--count" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], count)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], seed)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--width" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], opt.width)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--height" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], opt.height)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--walls" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], opt.wallDensity)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--boxes" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], opt.boxes)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--targets" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], opt.targets)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--workers" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], opt.workers)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--controllers" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], opt.controllers)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--reachable") {
+            opt.reachableOnly = true;
+        } else if (arg == "--max-attempts" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], opt.maxAttempts)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--binary") {
+            binary = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], threads)) return invalidValue(arg, argv[i]);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    if (outDir.empty()) {
+        std::cerr << "usage: oop_levelgen --out <dir> [--count N] [--seed S] ..." << std::endl;
+        return 2;
+    }
+
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    threads = (int)std::clamp<long>(threads, 1, std::max(1L, count));
+
+    const LevelGenerator gen(opt);
+    std::atomic<long> next{0}, written{0}, failed{0}, attemptsTotal{0};
+    std::atomic<bool> writeError{false};
+
+    auto worker = [&]() {
+        for (long i = next++; i < count; i = next++) {
+            const uint64_t s = seed + (uint64_t)i;
+            int attempts = 0;
+            auto lvl = gen.generate(s, &attempts);
+            attemptsTotal += attempts;
+            if (!lvl) {
+                ++failed;
+                continue;
+            }
+
+            std::string path = outDir + "/level_" + std::to_string(s) + (binary ? ".lvlb" : ".json");
+            std::ofstream f(path, std::ios::binary | std::ios::trunc);
+            if (binary) {
+                auto bytes = LevelCompiler::compile(*lvl);
+                f.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+            } else {
+                f << LevelGenerator::levelToJson(*lvl).dump() << '\n';
+            }
+
+            if (f) ++written;
+            else writeError = true;
+        }
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (writeError) {
+        std::cerr << "Cannot write levels to: " << outDir << std::endl;
+        return 1;
+    }
+
+    json summary = {
+        {"status", "ok"},
+        {"written", written.load()},
+        {"failed", failed.load()},
+        {"attempts", attemptsTotal.load()},
+        {"seconds", sec},
+        {"levels_per_sec", sec > 0 ? written.load() / sec : 0.0}
+    };
+    std::cout << summary.dump() << std::endl;
+    return failed > 0 ? 3 : 0;
+}
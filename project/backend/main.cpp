@@ -1,25 +1,271 @@
 #include <iostream>
+#include <string>
+#include <chrono>
+#include <charconv>
+#include <cstdint>
 #include <nlohmann/json.hpp>
 #include "GameEngine.hpp"
 #include "RequestHandler.hpp"
+#include "LevelBinary.hpp"
+#include "ReplayLog.hpp"
+#include "TrafficCapture.hpp"
+#include "PlacementSolver.hpp"
+#include "LevelLoader.hpp"
+#include "ObservationExporter.hpp"
+#include "Metrics.hpp"
 
 using json = nlohmann::json;
 
-int main() {
+// oop_backend --replay file.oopr [--seek N] [--headless]
+static int runReplay(const std::string& path, long long seek, bool headless) {
+    ReplayReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Cannot read replay: " << path << std::endl;
+        return 1;
+    }
+
     GameEngine engine;
+    reader.applySettings(engine);
+
+    // один обробник на все відтворення; рівні приходять записами Load,
+    // тож кеш файлів не потрібен
     RequestHandler handler(engine);
+    handler.levelCache().setCapacity(0);
+
+    if (seek >= 0) {
+        size_t replayed = 0;
+        if (!reader.seek(engine, handler, (uint32_t)seek, &replayed)) {
+            std::cerr << "Replay is corrupted" << std::endl;
+            return 1;
+        }
+        auto st = engine.getStateJson();
+        json resp = {
+            {"status", "ok"}, {"tick", engine.getLevel().getMoves()}, {"replayed", replayed},
+            {"state", st["state"]}, {"finished", st["finished"]}, {"win", st["win"]}
+        };
+        std::cout << resp.dump() << std::endl;
+        return 0;
+    }
+
+    uint64_t simulated = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = reader.replayAll(engine, handler, [&](uint32_t tick) {
+        if (headless) return;
+        auto st = engine.getStateJson();
+        std::cout << json{{"tick", tick}, {"state", st["state"]}}.dump() << '\n';
+    }, &simulated);
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (!ok) {
+        std::cerr << "Replay is corrupted" << std::endl;
+        return 1;
+    }
+
+    json summary = {
+        {"status", "ok"},
+        {"ticks", simulated},
+        {"records", reader.records().size()},
+        {"seconds", sec},
+        {"ticks_per_sec", sec > 0 ? simulated / sec : 0.0},
+        {"win", engine.isWin()}
+    };
+    std::cout << summary.dump() << std::endl;
+    return 0;
+}
+
+// oop_backend --solve level.json [--max-workers N] [--max-controllers N] ...
+static int runSolve(const std::string& path, const SolveOptions& opt) {
+    auto lvl = LevelLoader::load(path);
+    if (!lvl) {
+        std::cerr << "Cannot load level: " << path << std::endl;
+        return 1;
+    }
+
+    GameEngine engine;
+    engine.loadLevel(std::move(*lvl));
+
+    SolveResult res = PlacementSolver(engine, opt).solve();
+    json out = PlacementSolver::resultToJson(res);
+    out["status"] = "ok";
+    std::cout << out.dump() << std::endl;
+    return res.status == SolveResult::Status::Solved ? 0 : 3;
+}
+
+// число з аргументу цілком, без знаку для беззнакових типів
+template <class T>
+static bool parseNumber(const char* s, T& out) {
+    const char* end = s + std::char_traits<char>::length(s);
+    auto [p, ec] = std::from_chars(s, end, out);
+    return ec == std::errc() && p == end && p != s;
+}
+
+static int invalidValue(const std::string& option, const char* value) {
+    std::cerr << "Invalid value for " << option << ": " << value << std::endl;
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    // oop_backend --compile level.json level.lvlb
+    if (argc >= 2 && std::string(argv[1]) == "--compile") {
+        if (argc != 4) {
+            std::cerr << "usage: oop_backend --compile <in.json> <out.lvlb>" << std::endl;
+            return 2;
+        }
+        return LevelCompiler::compileFile(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    GameEngine engine;
+    RequestHandler handler(engine);
+    ReplayWriter recorder;
+
+    TrafficCapture capture;
+    ObservationExporter observations;
+    Metrics metrics;
+    handler.setMetrics(&metrics);
+
+    std::string recordPath, replayPath, capturePath, benchPath, solvePath, obsShmName, metricsPath;
+    int metricsIntervalMs = 10000;
+    SolveOptions solveOpt;
+    uint32_t keyframeInterval = 100;
+    long long seek = -1;
+    bool headless = false;
+    bool paced = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--level-cache-mb" && i + 1 < argc) {
+            size_t mb;
+            if (!parseNumber(argv[++i], mb) || mb > (SIZE_MAX >> 20)) return invalidValue(arg, argv[i]);
+            handler.levelCache().setCapacity(mb << 20);
+        } else if (arg == "--history-depth" && i + 1 < argc) {
+            size_t depth;
+            if (!parseNumber(argv[++i], depth)) return invalidValue(arg, argv[i]);
+            engine.setHistoryDepth(depth);
+        } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+            int ticks;
+            if (!parseNumber(argv[++i], ticks)) return invalidValue(arg, argv[i]);
+            engine.setCheckpointInterval(ticks);
+        } else if (arg == "--no-fast-forward") {
+            engine.setFastForward(false);
+        } else if (arg == "--no-early-lose") {
+            engine.setEarlyLose(false);
+        } else if (arg == "--no-bitboard") {
+            engine.setBitboard(false);
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--keyframe-interval" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], keyframeInterval)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--seek" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], seek)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (arg == "--bench-capture" && i + 1 < argc) {
+            benchPath = argv[++i];
+        } else if (arg == "--obs-shm" && i + 1 < argc) {
+            obsShmName = argv[++i];
+        } else if (arg == "--metrics-file" && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (arg == "--metrics-interval-ms" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], metricsIntervalMs)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--paced") {
+            paced = true;
+        } else if (arg == "--solve" && i + 1 < argc) {
+            solvePath = argv[++i];
+        } else if (arg == "--max-workers" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], solveOpt.maxWorkers)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--max-controllers" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], solveOpt.maxControllers)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--max-ticks" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], solveOpt.maxTicks)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--max-nodes" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], solveOpt.maxNodes)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--time-limit-ms" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], solveOpt.timeLimitMs)) return invalidValue(arg, argv[i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            if (!parseNumber(argv[++i], solveOpt.threads)) return invalidValue(arg, argv[i]);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    if (!replayPath.empty())
+        return runReplay(replayPath, seek, headless);
+
+    if (!benchPath.empty())
+        return runCaptureBench(benchPath, paced);
+
+    if (!solvePath.empty())
+        return runSolve(solvePath, solveOpt);
+
+    if (!capturePath.empty() && !capture.open(capturePath)) {
+        std::cerr << "Cannot write capture: " << capturePath << std::endl;
+        return 1;
+    }
+
+    if (!recordPath.empty()) {
+        if (!recorder.open(recordPath, keyframeInterval, engine)) {
+            std::cerr << "Cannot write replay: " << recordPath << std::endl;
+            return 1;
+        }
+        handler.setRecorder(&recorder);
+    }
+
+    if (!obsShmName.empty() && !observations.open(obsShmName)) {
+        std::cerr << "Cannot create shared memory: " << obsShmName << std::endl;
+        return 1;
+    }
+
+    if (!metricsPath.empty() && !metrics.startFileDump(metricsPath, metricsIntervalMs)) {
+        std::cerr << "Cannot write metrics: " << metricsPath << std::endl;
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto started = Clock::now();
+    auto nanosSince = [](Clock::time_point a, Clock::time_point b) {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count();
+    };
 
     std::string line;
     while (std::getline(std::cin, line)) {
         if (line.empty()) continue;
+
+        auto t0 = Clock::now();
+        std::string out;
+        int action = Metrics::Other;
+        bool failed = false;
         try {
             json req = json::parse(line);
+            if (auto it = req.find("action"); it != req.end() && it->is_string())
+                action = Metrics::actionIndex(it->get_ref<const std::string&>());
             json resp = handler.handle(req);
-            std::cout << resp.dump() << std::endl;
+            auto status = resp.find("status");
+            failed = status != resp.end() && *status == "error";
+            out = resp.dump();
         } catch (const std::exception& e) {
             json resp = { {"status","error"}, {"message", e.what()} };
-            std::cout << resp.dump() << std::endl;
+            out = resp.dump();
+            failed = true;
         }
+        // кадр готовий раніше за відповідь: клієнт, що її прочитав, бачить новий стан
+        if (observations.isOpen())
+            observations.publish({ &engine });
+
+        std::cout << out << std::endl;
+
+        const uint64_t latency = nanosSince(t0, Clock::now());
+        metrics.record(action, latency, line.size() + 1, out.size() + 1, failed);
+        metrics.observeEngine(engine);
+
+        if (capture.isOpen())
+            capture.record(nanosSince(started, t0), latency, out.size(), line);
     }
+    metrics.stopFileDump();
     return 0;
 }
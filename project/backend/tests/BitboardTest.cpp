@@ -0,0 +1,112 @@
+#include "GameEngine.hpp"
+#include "BitboardEngine.hpp"
+#include "ControllerRobot.hpp"
+#include "LevelGenerator.hpp"
+#include "TestUtil.hpp"
+#include <random>
+
+static std::optional<Level> smallLevel(uint64_t seed, std::mt19937& rng, bool anyCommand) {
+    LevelGenOptions o;
+    o.width = 4 + rng() % 13;
+    o.height = 4 + rng() % 13;
+    while (o.width * o.height > 256) --o.height;
+    o.wallDensity = 0.05 * (rng() % 4);
+    o.boxes = o.targets = 1 + rng() % 3;
+    o.workers = 1 + rng() % 4;
+    o.controllers = rng() % 3;
+    auto lvl = LevelGenerator(o).generate(seed);
+    if (!lvl) return lvl;
+
+    // повороти підтримуються бітбордами, решта команд — запасний шлях
+    int ids = (int)lvl->getRobotStates().size();
+    for (auto& r : lvl->getRobots())
+        if (auto* c = dynamic_cast<ControllerRobot*>(r.get())) {
+            if (rng() % 3 == 0) continue;
+            CommandType t = rng() % 2 ? CommandType::RotateCW : CommandType::RotateCCW;
+            if (anyCommand && rng() % 4 == 0) t = CommandType::Move;
+            c->setCommand(Command{ 1 + (int)(rng() % ids), t, (Direction)(rng() % 4) });
+        }
+    return lvl;
+}
+
+static void configure(GameEngine& e, bool bitboard, bool earlyLose) {
+    e.setBitboard(bitboard);
+    e.setEarlyLose(earlyLose);
+    e.setHistoryDepth(0);
+    e.setCheckpointInterval(0);
+}
+
+// Кожен крок бітбордового рушія — проти стількох самих stepAuto
+// загального: хеш і стан гри після кожного кроку, повний стан — у кінці.
+static void advanceMatchesSteps() {
+    std::mt19937 rng(45);
+    int compared = 0;
+    for (uint64_t seed = 1; seed <= 400; ++seed) {
+        auto lvl = smallLevel(seed, rng, false);
+        if (!lvl) continue;
+
+        GameEngine start, plain;
+        configure(start, true, seed % 2 == 0);
+        configure(plain, false, seed % 2 == 0);
+        plain.setFastForward(false);
+        start.loadLevel(Level(*lvl));
+        plain.loadLevel(Level(*lvl));
+
+        withBitboardEngine(start, [&](auto& bb) {
+            ++compared;
+            int ticks = 0;
+            while (ticks < 3000 && !bb.isFinished()) {
+                int k = bb.advance(1 + (int)(rng() % 64));
+                if (k == 0) break;
+                ticks += k;
+                for (int i = 0; i < k && !plain.isFinished(); ++i) plain.stepAuto();
+
+                bool same = bb.getStateHash() == plain.getStateHash() &&
+                            bb.isWin() == plain.isWin() && bb.isLose() == plain.isLose() &&
+                            bb.isNonTerminating() == plain.isNonTerminating();
+                CHECK(same);
+                if (!same) {
+                    std::cerr << "seed " << seed << " tick " << ticks << std::endl;
+                    return;
+                }
+            }
+
+            GameEngine probe = start.clone();
+            bb.store(probe);
+            CHECK(probe.getStateJson() == plain.getStateJson());
+            CHECK(probe.getLevel().getMoves() == plain.getLevel().getMoves());
+        });
+    }
+    CHECK(compared > 100);
+}
+
+// run_until_finished з бітбордами й без: той самий результат і стан,
+// зокрема коли бітборди на півдорозі віддають прогін загальному рушію
+static void runUntilFinishedMatches() {
+    std::mt19937 rng(4500);
+    for (uint64_t seed = 1; seed <= 400; ++seed) {
+        auto lvl = smallLevel(seed, rng, true);
+        if (!lvl) continue;
+
+        GameEngine bit, plain;
+        configure(bit, true, seed % 2 == 0);
+        configure(plain, false, seed % 2 == 0);
+        bit.loadLevel(Level(*lvl));
+        plain.loadLevel(Level(*lvl));
+        CHECK(bit.bitboardWords() > 0);
+
+        auto a = bit.runUntilFinished(3000);
+        auto b = plain.runUntilFinished(3000);
+        CHECK(a.ticks == b.ticks);
+        CHECK(a.win == b.win && a.lose == b.lose && a.nonTerminating == b.nonTerminating);
+        CHECK(bit.getStateJson() == plain.getStateJson());
+        CHECK(bit.getStateHash() == plain.getStateHash());
+        CHECK(bit.getLevel().getMoves() == plain.getLevel().getMoves());
+    }
+}
+
+int main() {
+    advanceMatchesSteps();
+    runUntilFinishedMatches();
+    return testFailures();
+}
@@ -0,0 +1,100 @@
+#include "GameEngine.hpp"
+#include "ControllerRobot.hpp"
+#include "LevelGenerator.hpp"
+#include "TestUtil.hpp"
+#include <random>
+
+// стан, який бачить клієнт, плюс те, що рушій веде поза ним
+static bool sameState(const GameEngine& a, const GameEngine& b) {
+    return a.getStateJson() == b.getStateJson() &&
+           a.getStateHash() == b.getStateHash() &&
+           a.getLevel().getMoves() == b.getLevel().getMoves() &&
+           a.isWin() == b.isWin() && a.isLose() == b.isLose() &&
+           a.isHopeless() == b.isHopeless() &&
+           a.isNonTerminating() == b.isNonTerminating();
+}
+
+// контролерам — випадкові повороти, щоб тихі відрізки переривались
+static void giveCommands(Level& lvl, std::mt19937& rng) {
+    int ids = (int)lvl.getRobotStates().size();
+    for (auto& r : lvl.getRobots())
+        if (auto* c = dynamic_cast<ControllerRobot*>(r.get()))
+            if (rng() % 2)
+                c->setCommand(Command{ 1 + (int)(rng() % ids),
+                                       rng() % 2 ? CommandType::RotateCW : CommandType::RotateCCW,
+                                       Direction::Up });
+}
+
+// Стрибок advance через тихі ходи має давати те саме, що стільки ж
+// звичайних stepAuto, — після кожного стрибка, а не лише в кінці.
+static void advanceMatchesSteps() {
+    std::mt19937 rng(34);
+    for (uint64_t seed = 1; seed <= 300; ++seed) {
+        LevelGenOptions o;
+        o.width = 6 + rng() % 14;
+        o.height = 6 + rng() % 14;
+        o.wallDensity = 0.05 * (rng() % 4);
+        o.boxes = o.targets = 1 + rng() % 3;
+        o.workers = 1 + rng() % 4;
+        o.controllers = rng() % 3;
+        auto lvl = LevelGenerator(o).generate(seed);
+        if (!lvl) continue;
+        giveCommands(*lvl, rng);
+
+        GameEngine fast, plain;
+        for (GameEngine* e : { &fast, &plain }) {
+            e->setBitboard(false);
+            e->setEarlyLose(seed % 2 == 0);
+            e->loadLevel(Level(*lvl));
+        }
+        fast.setFastForward(true);
+        plain.setFastForward(false);
+
+        for (int guard = 0; guard < 2000 && !fast.isFinished(); ++guard) {
+            int n = fast.advance(1 + (int)(rng() % 64));
+            for (int i = 0; i < n && !plain.isFinished(); ++i) plain.stepAuto();
+            CHECK(sameState(fast, plain));
+            if (!sameState(fast, plain)) {
+                std::cerr << "seed " << seed << " tick " << fast.getLevel().getMoves() << std::endl;
+                break;
+            }
+        }
+    }
+}
+
+// run_until_finished зі стрибками і без них — той самий результат
+static void runUntilFinishedMatches() {
+    std::mt19937 rng(3400);
+    for (uint64_t seed = 1; seed <= 200; ++seed) {
+        LevelGenOptions o;
+        o.width = 8 + rng() % 24;
+        o.height = 8 + rng() % 24;
+        o.wallDensity = 0.1;
+        o.boxes = o.targets = 2;
+        o.workers = 1 + rng() % 3;
+        o.controllers = rng() % 2;
+        auto lvl = LevelGenerator(o).generate(seed);
+        if (!lvl) continue;
+        giveCommands(*lvl, rng);
+
+        GameEngine fast, plain;
+        for (GameEngine* e : { &fast, &plain }) {
+            e->setBitboard(false);
+            e->loadLevel(Level(*lvl));
+        }
+        fast.setFastForward(true);
+        plain.setFastForward(false);
+
+        auto a = fast.runUntilFinished(5000);
+        auto b = plain.runUntilFinished(5000);
+        CHECK(a.ticks == b.ticks);
+        CHECK(a.win == b.win && a.lose == b.lose && a.nonTerminating == b.nonTerminating);
+        CHECK(sameState(fast, plain));
+    }
+}
+
+int main() {
+    advanceMatchesSteps();
+    runUntilFinishedMatches();
+    return testFailures();
+}
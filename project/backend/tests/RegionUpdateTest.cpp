@@ -0,0 +1,57 @@
+#include "Level.hpp"
+#include "TestUtil.hpp"
+#include <map>
+#include <random>
+
+// Області після addWall/addTarget мають збігатися з повним перебудуванням
+// через setTerrain. Номери областей можуть відрізнятися — порівнюється
+// розбиття (взаємно однозначна відповідність номерів) і відстані до цілей.
+static bool sameRegions(const Level& a, const Level& b) {
+    const auto ga = a.getGrid(), gb = b.getGrid();
+    std::map<int,int> ab, ba;
+    for (int y = 0; y < a.getHeight(); ++y)
+        for (int x = 0; x < a.getWidth(); ++x) {
+            if (a.targetDistance(x, y) != b.targetDistance(x, y)) return false;
+            if (ga[y][x] != gb[y][x]) return false;
+            if (a.getCell(x, y).type != b.getCell(x, y).type) return false;
+
+            int ca = a.componentAt(x, y), cb = b.componentAt(x, y);
+            if ((ca < 0) != (cb < 0)) return false;
+            if (ca < 0) continue;
+            if (ab.emplace(ca, cb).first->second != cb) return false;
+            if (ba.emplace(cb, ca).first->second != ca) return false;
+        }
+    return true;
+}
+
+int main() {
+    std::mt19937 rng(39);
+    for (int it = 0; it < 1500; ++it) {
+        int W = 1 + rng() % 14, H = 1 + rng() % 14;
+        Level inc(W, H);
+        std::vector<std::pair<int,int>> walls, targets;
+
+        int n = rng() % (W * H + 5);
+        for (int k = 0; k < n; ++k) {
+            int x = rng() % W, y = rng() % H;
+            if (rng() % 4 == 0) {
+                inc.addTarget(x, y);
+                targets.push_back({ x, y });
+            } else {
+                inc.addWall(x, y);
+                walls.push_back({ x, y });
+            }
+            if (rng() % 3) continue;
+
+            Level full(W, H);
+            full.setTerrain(walls, targets, {});
+            bool same = sameRegions(inc, full);
+            CHECK(same);
+            if (!same) {
+                std::cerr << "iteration " << it << " " << W << "x" << H << std::endl;
+                return testFailures();
+            }
+        }
+    }
+    return testFailures();
+}
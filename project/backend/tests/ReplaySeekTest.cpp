@@ -0,0 +1,123 @@
+#include "GameEngine.hpp"
+#include "ControllerRobot.hpp"
+#include "LevelGenerator.hpp"
+#include "ReplayLog.hpp"
+#include "RequestHandler.hpp"
+#include "TestUtil.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <random>
+#include <set>
+
+using json = nlohmann::json;
+
+struct Snap {
+    std::string state;
+    uint64_t hash = 0;
+    bool finished = false, hopeless = false, manual = false, nonTerminating = false, running = false;
+    std::vector<uint64_t> seen;
+
+    bool operator==(const Snap& o) const {
+        return state == o.state && hash == o.hash && finished == o.finished &&
+               hopeless == o.hopeless && manual == o.manual &&
+               nonTerminating == o.nonTerminating && running == o.running && seen == o.seen;
+    }
+};
+
+static Snap snap(const GameEngine& e) {
+    Snap s;
+    s.state = e.getStateJson().dump();
+    s.hash = e.getStateHash();
+    s.finished = e.isFinished();
+    s.hopeless = e.isHopeless();
+    s.manual = e.hadManualCommands();
+    s.nonTerminating = e.isNonTerminating();
+    s.running = e.isRunning();
+    e.seenStates().forEach([&](uint64_t h) { s.seen.push_back(h); });
+    std::sort(s.seen.begin(), s.seen.end());
+    return s;
+}
+
+// Живий сеанс пишеться в журнал; стан знімається, коли хід уперше
+// досягнуто цілим запитом. seek до цього ходу має дати той самий стан —
+// з keyframe-а й відтворення вперед. Ходи, через які запит лише пройшов
+// (run_until_finished, ручний step), живими не видно — їх не перевіряємо.
+int main() {
+    const std::string levelPath = "ReplaySeekTest.json";
+    const std::string logPath = "ReplaySeekTest.oopr";
+
+    std::mt19937 rng(31);
+    int checked = 0;
+    for (uint64_t seed = 1; seed <= 40; ++seed) {
+        LevelGenOptions o;
+        o.width = 8 + rng() % 8;
+        o.height = 8 + rng() % 8;
+        o.wallDensity = 0.1;
+        o.boxes = o.targets = 3;
+        o.workers = 3;
+        o.controllers = 2;
+        auto lvl = LevelGenerator(o).generate(seed);
+        if (!lvl) continue;
+        std::ofstream(levelPath) << LevelGenerator::levelToJson(*lvl).dump();
+
+        std::map<uint32_t, Snap> live;
+        {
+            GameEngine eng;
+            eng.setEarlyLose(seed % 3 != 0);
+            eng.setFastForward(seed % 4 != 0);
+            RequestHandler handler(eng);
+            ReplayWriter writer;
+            CHECK(writer.open(logPath, 1 + rng() % 8, eng));
+            handler.setRecorder(&writer);
+
+            std::set<uint32_t> passed;
+            uint32_t prev = 0;
+            auto request = [&](const json& req) {
+                handler.handle(req);
+                uint32_t tick = (uint32_t)eng.getLevel().getMoves();
+                for (uint32_t t = prev + 1; t < tick; ++t) passed.insert(t);
+                if (passed.insert(tick).second) live[tick] = snap(eng);
+                prev = tick;
+            };
+
+            request({ {"action", "load_level"}, {"path", levelPath} });
+            std::vector<int> ids;
+            for (auto& r : eng.getLevel().getRobots()) ids.push_back(r->getState()->id);
+
+            for (int op = 0; op < 60; ++op) {
+                switch (rng() % 8) {
+                    case 0:
+                        request({ {"action", "step"}, {"commands", { {
+                            {"robot_id", ids[rng() % ids.size()]},
+                            {"cmd", rng() % 2 ? "rotate_cw" : "rotate_ccw"} } } } });
+                        break;
+                    case 1: request({ {"action", "undo"} }); break;
+                    case 2: request({ {"action", "rewind"}, {"n", 1 + rng() % 4} }); break;
+                    case 3: request({ {"action", "run_until_finished"}, {"max_ticks", 50 + rng() % 200} }); break;
+                    case 4: if (rng() % 4 == 0) request({ {"action", "reset_keep_placements"} }); break;
+                    default: request({ {"action", "run_step"} }); break;
+                }
+            }
+        }
+
+        ReplayReader reader;
+        CHECK(reader.open(logPath));
+        for (auto& [tick, expected] : live) {
+            GameEngine eng;
+            reader.applySettings(eng);
+            RequestHandler handler(eng);
+            CHECK(reader.seek(eng, handler, tick));
+
+            bool same = snap(eng) == expected;
+            CHECK(same);
+            if (!same) {
+                std::cerr << "seed " << seed << " tick " << tick << std::endl;
+                break;
+            }
+            ++checked;
+        }
+    }
+    CHECK(checked > 500);
+    return testFailures();
+}
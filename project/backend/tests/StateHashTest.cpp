@@ -0,0 +1,100 @@
+#include "GameEngine.hpp"
+#include "ControllerRobot.hpp"
+#include "WorkerRobot.hpp"
+#include "TestUtil.hpp"
+
+// хеш, який рушій веде покроково, має збігатися з порахованим заново
+static bool hashInSync(const GameEngine& eng) {
+    GameEngine fresh = eng.clone();
+    fresh.rehash();
+    return fresh.getStateHash() == eng.getStateHash();
+}
+
+static std::unique_ptr<Robot> worker(int x, int y, Direction d) {
+    auto r = std::make_unique<WorkerRobot>();
+    r->setPosition(x, y);
+    r->setDirection(d);
+    return r;
+}
+
+// Ручні кроки роблять світ недетермінованим: стан, бачений до них, може
+// повторитись без жодного циклу. Робітник іде праворуч, розвертається,
+// повертається назад і знову йде праворуч тими самими клітинками.
+static void manualStepsThenRun() {
+    Level lvl(10, 3);
+    lvl.setTerrain({}, { {9, 0} }, { {8, 0} });
+    lvl.addRobot(worker(1, 1, Direction::Right));
+
+    GameEngine eng;
+    eng.setEarlyLose(false);
+    eng.loadLevel(std::move(lvl));
+
+    for (int i = 0; i < 3; ++i) eng.stepAuto();   // x = 4
+    Command cw{ 1, CommandType::RotateCW, Direction::Up };
+    eng.applyCommands({ cw });
+    eng.applyCommands({ cw });                     // ліворуч
+    CHECK(hashInSync(eng));
+    eng.stepAuto();
+    eng.stepAuto();                                // x = 2
+    eng.applyCommands({ cw });
+    eng.applyCommands({ cw });                     // знову праворуч
+
+    while (!eng.isFinished()) {
+        eng.stepAuto();
+        CHECK(!eng.isNonTerminating());
+        CHECK(hashInSync(eng));
+    }
+    CHECK(eng.isLose());
+    CHECK(!eng.isNonTerminating());
+}
+
+// ручна команда, що нічого не змінила, не скидає виявлення циклів
+static void noopCommandKeepsSeen() {
+    Level lvl(6, 3);
+    lvl.setTerrain({}, { {5, 0} }, { {4, 0} });
+    lvl.addRobot(worker(1, 1, Direction::Right));
+
+    GameEngine eng;
+    eng.setEarlyLose(false);
+    eng.loadLevel(std::move(lvl));
+    eng.stepAuto();
+
+    size_t seen = eng.seenStates().size();
+    eng.applyCommands({});
+    CHECK(eng.seenStates().size() == seen);
+}
+
+// Контролер командою Move зрушує робітника разом із коробкою: ключ
+// коробки має вийти з хешу й повернутися з новою клітинкою.
+static void controllerMovesCarriedBox() {
+    Level lvl(6, 3);
+    lvl.setTerrain({}, { {5, 0} }, { {2, 1} });
+    lvl.addRobot(worker(1, 1, Direction::Right));
+
+    auto ctl = std::make_unique<ControllerRobot>();
+    ctl->setPosition(4, 1);
+    ctl->setDirection(Direction::Left);
+    ctl->setCommand(Command{ 1, CommandType::Move, Direction::Up });
+    lvl.addRobot(std::move(ctl));
+
+    GameEngine eng;
+    eng.setEarlyLose(false);
+    eng.setFastForward(false);
+    eng.loadLevel(std::move(lvl));
+
+    bool moved = false;
+    for (int i = 0; i < 6 && !eng.isFinished(); ++i) {
+        eng.stepAuto();
+        CHECK(hashInSync(eng));
+        for (auto& b : eng.getLevel().getBoxes())
+            moved |= b.y == 0;
+    }
+    CHECK(moved);
+}
+
+int main() {
+    manualStepsThenRun();
+    noopCommandKeepsSeen();
+    controllerMovesCarriedBox();
+    return testFailures();
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <iostream>
+
+// Тести без фреймворку: CHECK друкує місце провалу й рахує провали,
+// main повертає testFailures() — ctest бачить ненульовий код.
+inline int& testFailures() {
+    static int n = 0;
+    return n;
+}
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            ++testFailures();                                                    \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ")"    \
+                      << std::endl;                                              \
+        }                                                                        \
+    } while (0)
@@ -0,0 +1,118 @@
+#include "GameEngine.hpp"
+#include "ControllerRobot.hpp"
+#include "LevelGenerator.hpp"
+#include "TestUtil.hpp"
+#include <random>
+#include <sstream>
+
+// Усе, що undo має повернути: знімок рівня (роботи з командами, коробки,
+// хід), порядок списків роботів, хеш і стан прогону.
+struct Saved {
+    std::string state;
+    uint64_t hash = 0;
+    int moves = 0;
+    bool running = false;
+    std::vector<int> order, placedOrder;
+
+    bool operator==(const Saved& o) const {
+        return state == o.state && hash == o.hash && moves == o.moves &&
+               running == o.running && order == o.order && placedOrder == o.placedOrder;
+    }
+};
+
+static Saved save(const GameEngine& e) {
+    std::ostringstream out;
+    const LevelSnapshot snap = e.getLevel().snapshot();
+    for (auto& r : snap.robots) {
+        const RobotState& s = r.state;
+        out << s.id << ' ' << (int)s.type << ' ' << s.x << ' ' << s.y << ' ' << s.alive << ' '
+            << s.carrying << ' ' << s.boxId.value_or(-1) << ' ' << (int)s.dir << ' '
+            << r.listed << r.placed << r.hasCommand;
+        if (r.hasCommand)
+            out << ' ' << (int)r.command.type << ' ' << r.command.robotId << ' ' << (int)r.command.dir;
+        out << ';';
+    }
+    for (auto& b : snap.boxes)
+        out << b.id << ' ' << b.x << ' ' << b.y << ' ' << b.delivered << ';';
+
+    Saved s;
+    s.state = out.str();
+    s.hash = e.getStateHash();
+    s.moves = e.getLevel().getMoves();
+    s.running = e.isRunning();
+    for (auto& r : e.getLevel().getRobots()) s.order.push_back(r->getState()->id);
+    for (auto& r : e.getLevel().getPlacedRobots()) s.placedOrder.push_back(r->getState()->id);
+    return s;
+}
+
+// Випадкові ручні команди, ходи й стрибки; після кожної дії стан іде в стек.
+// undo(n) має скасувати не більше, ніж зроблено, і повернути саме той стан,
+// що лежить у стеку на n позицій нижче.
+int main() {
+    std::mt19937 rng(30);
+    int undos = 0;
+    for (uint64_t seed = 1; seed <= 1000; ++seed) {
+        LevelGenOptions o;
+        o.width = 6 + rng() % 10;
+        o.height = 6 + rng() % 10;
+        o.wallDensity = 0.12;
+        o.boxes = o.targets = 3;
+        o.workers = 2 + rng() % 4;
+        o.controllers = rng() % 3;
+        auto lvl = LevelGenerator(o).generate(seed);
+        if (!lvl) continue;
+
+        int ids = (int)lvl->getRobotStates().size();
+        for (auto& r : lvl->getRobots())
+            if (auto* c = dynamic_cast<ControllerRobot*>(r.get()))
+                c->setCommand(Command{ 1 + (int)(rng() % ids),
+                                       rng() % 2 ? CommandType::RotateCW : CommandType::RotateCCW,
+                                       Direction::Up });
+
+        GameEngine e;
+        e.setHistoryDepth(1 + rng() % 40);
+        e.setFastForward(rng() % 2);
+        e.loadLevel(std::move(*lvl));
+
+        std::vector<Saved> stack{ save(e) };
+        for (int op = 0; op < 80 && !e.isFinished(); ++op) {
+            int kind = rng() % 10;
+            auto& robots = e.getLevelMutable().getRobots();
+            if (kind <= 2 && !robots.empty()) {
+                std::vector<Command> cmds;
+                for (int k = 0; k < 2; ++k) {
+                    const RobotState* s = robots[rng() % robots.size()]->getState();
+                    if (s->type == RobotType::Controller)
+                        cmds.push_back(Command{ 1 + (int)(rng() % ids),
+                                                rng() % 2 ? CommandType::RotateCW : CommandType::RotateCCW,
+                                                Direction::Up });
+                    else
+                        cmds.push_back(Command{ s->id, (CommandType)(rng() % 8), (Direction)(rng() % 4) });
+                }
+                e.applyCommands(cmds);
+            } else if (kind <= 5) {
+                e.advance(1 + rng() % 30);
+            } else {
+                e.stepAuto();
+            }
+            stack.push_back(save(e));
+
+            if (rng() % 6 == 0) {
+                size_t undone = e.undo(1 + rng() % 5);
+                ++undos;
+                CHECK(undone < stack.size());
+                if (undone >= stack.size()) break;
+
+                stack.resize(stack.size() - undone);
+                bool same = save(e) == stack.back();
+                CHECK(same);
+                if (!same) {
+                    std::cerr << "seed " << seed << " op " << op << " undo " << undone << std::endl;
+                    break;
+                }
+            }
+        }
+    }
+    CHECK(undos > 500);
+    return testFailures();
+}
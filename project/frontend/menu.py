@@ -219,6 +219,7 @@ class GameRunner(tk.Toplevel):
         self.title(filename)
         self.backend = backend
         self.level_path = level_path 
+        self.filename = filename
         self.initial_state = initial_state
 
         self.game = GameWindow(self, backend, initial_state)
@@ -291,19 +292,12 @@ class GameRunner(tk.Toplevel):
 
     def restart_level(self, win):
         win.destroy()
-      
-        self.backend.stop()
-        self.destroy()
-
-        backend = BackendProcess()
-        backend.start()
 
-        resp = backend.send({
-            "action": "load_level",
-            "path": self.level_path
-        })
+        # бекенд повертає початковий стан рівня без перезапуску процесу
+        resp = self.backend.send({"action": "reset"})
+        self.destroy()
 
-        GameRunner(self.master, backend, self.level_path, resp)
+        GameRunner(self.master, self.backend, self.level_path, resp, self.filename)
 
 
 